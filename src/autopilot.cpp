@@ -0,0 +1,41 @@
+#include <cmath>
+
+#include "autopilot.h"
+
+// Cells along straight runs are left out, the player walks from corner to corner.
+void Autopilot::follow(const Map &map, const std::vector<uint32_t> &path, float goalX, float goalY) {
+    waypointsX.clear();
+    waypointsY.clear();
+    nextWaypoint = 0;
+    if (path.empty()) return;
+
+    uint32_t width = (uint32_t)map.getWidth();
+    for (size_t i = 1; i < path.size(); i++) {
+        bool last = i + 1 == path.size();
+        if (!last && path[i] - path[i - 1] == path[i + 1] - path[i]) continue;
+        waypointsX.push_back((float)(path[i] % width) + 0.5f);
+        waypointsY.push_back((float)(path[i] / width) + 0.5f);
+    }
+    waypointsX.push_back(goalX);
+    waypointsY.push_back(goalY);
+}
+
+PlayerInput Autopilot::steer(const Player &player) {
+    PlayerInput input;
+    while (!isFinished() && std::hypot(waypointsX[nextWaypoint] - player.getX(), waypointsY[nextWaypoint] - player.getY()) < reachDistance)
+        nextWaypoint++;
+    if (isFinished()) return input;
+
+    // 0 degrees is positive y and angles grow towards positive x, turning right increases the angle.
+    float targetAngle = atan2f(waypointsX[nextWaypoint] - player.getX(), waypointsY[nextWaypoint] - player.getY()) * 180.f / (float)M_PI;
+    float error = targetAngle - player.getAngle();
+    while (error > 180)
+        error -= 360;
+    while (error < -180)
+        error += 360;
+
+    if (error > aimTolerance) input.keys |= PlayerInput::Right;
+    if (error < -aimTolerance) input.keys |= PlayerInput::Left;
+    if (fabsf(error) < walkTolerance) input.keys |= PlayerInput::Forward;
+    return input;
+}
@@ -0,0 +1,30 @@
+#ifndef autopilotH
+#define autopilotH
+
+#include <vector>
+
+#include "map.h"
+#include "player.h"
+
+// Drives a Player along a solved path by pressing the same movement keys a player would,
+// so movement and collision are exactly those of manual play. Turns in place at corners.
+class Autopilot {
+    std::vector<float> waypointsX, waypointsY; // Centers of the cells where the path turns, then the goal.
+    size_t nextWaypoint = 0;
+
+    static constexpr float reachDistance = 0.1f; // In tiles, a waypoint closer than this is passed.
+    static constexpr float aimTolerance = 2.f;   // In degrees, smaller errors are not turned against.
+    static constexpr float walkTolerance = 10.f; // In degrees, larger errors are turned without walking.
+
+public:
+    // Follow path, cell indices of map from Map::findPath, then walk on to (goalX, goalY).
+    void follow(const Map &map, const std::vector<uint32_t> &path, float goalX, float goalY);
+
+    // Whether the goal has been reached, or there is no path.
+    bool isFinished() const { return nextWaypoint >= waypointsX.size(); }
+
+    // Keys to hold for the next simulation tick of player.
+    PlayerInput steer(const Player &player);
+};
+
+#endif
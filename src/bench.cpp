@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+
+#include "autopilot.h"
+#include "camerapath.h"
+#include "framebuffer.h"
+#include "map.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "texturecache.h"
+
+// Headless benchmarks, need no display.
+//
+// --mode frames (default) replays a deterministic camera path through a seeded maze
+// and reports frame rate, frame time percentiles and ray steps.
+// Usage: ./bench [--width 1280] [--height 720] [--scale 1] [--frames 600] [--warmup 30]
+//                [--maze 51] [--seed 1] [--threads 0] [--ray-casting dda|marching]
+//                [--chunked 0|1] [--isa best|scalar|avx2|avx512] [--skip-empty 0|1] [--planes 0|1]
+//                [--mipmaps 0|1] [--wall-texture path.ppm] [--sprites 0] [--camera path|autopilot] [--screenshot last.ppm] [--trace trace.json] (needs make PROFILING=1)
+// --wall-texture puts one texture on every wall, --screenshot saves the last frame to compare image quality.
+// --sprites scatters that many pickups over random empty cells of a flat maze.
+// --camera autopilot walks the maze's solution at player speed instead of following the right hand wall.
+//
+// --mode rays casts the columns of the same camera path on one thread with every instruction set
+// the CPU supports, with and without skipping lookups of known empty cells, without drawing. Checks that all of them hit
+// exactly what scalar casting hits, and reports cells entered, DDA iterations and map lookups per ray.
+// Usage: ./bench --mode rays [--width 1280] [--height 720] [--scale 1] [--frames 600] [--maze 51] [--seed 1] [--hall 0]
+// --hall clears the maze once the camera path is laid out, leaving a pillar every that many cells, for open space to skip.
+//
+// --mode maze times the iterative maze generator against the original recursive one.
+// Usage: ./bench --mode maze [--sizes 101,1001,3001,10001] [--repeat 3] [--seed 1] [--threads 0]
+//
+// --mode solve times Map::solve on generated mazes, checks that every path is a walk of empty cells from the entrance
+// to the exit, and reports the memory its visited and direction bits take.
+// Usage: ./bench --mode solve [--sizes 101,1001,3001,10001] [--repeat 3] [--seed 1] [--threads 0]
+
+namespace {
+double percentile(const std::vector<double> &sorted, double fraction) {
+    size_t idx = std::min(sorted.size() - 1, (size_t)(fraction * (double)(sorted.size() - 1) + 0.5));
+    return sorted[idx];
+}
+
+RayCastingIsa parseIsa(const std::string &name) {
+    for (RayCastingIsa isa : {RayCastingIsa::Scalar, RayCastingIsa::AVX2, RayCastingIsa::AVX512}) {
+        if (name == PacketCaster::getName(isa)) return isa;
+    }
+    return PacketCaster::getBestIsa();
+}
+
+// Write frameBuffer as a binary .ppm file.
+bool writeScreenshot(const FrameBuffer &frameBuffer, const std::string &filePath) {
+    std::ofstream file(filePath, std::ios::binary);
+    file << "P6\n" << frameBuffer.getLength() << " " << frameBuffer.getHeight() << "\n255\n";
+    for (size_t i = 0; i < frameBuffer.getLength() * frameBuffer.getHeight(); i++) {
+        sf::Color color = toColor(frameBuffer.getPixels()[i]);
+        file.put((char)color.r).put((char)color.g).put((char)color.b);
+    }
+    return (bool)file;
+}
+
+bool sameHit(const RayHit &a, const RayHit &b) {
+    return std::memcmp(&a.x, &b.x, sizeof(float)) == 0 && std::memcmp(&a.y, &b.y, sizeof(float)) == 0 &&
+           std::memcmp(&a.distance, &b.distance, sizeof(float)) == 0 && std::memcmp(&a.textureX, &b.textureX, sizeof(float)) == 0 &&
+           a.cellX == b.cellX && a.cellY == b.cellY && a.hitFromX == b.hitFromX && a.cells == b.cells;
+}
+
+int benchRayCasting(std::map<std::string, std::string> &options) {
+    size_t scale = std::stoul(options["scale"]);
+    size_t frames = std::stoul(options["frames"]);
+    int mazeSize = std::stoi(options["maze"]);
+    mazeSize += 1 - mazeSize % 2; // Ensure odd dimensions
+
+    Map map(mazeSize, mazeSize, std::stoull(options["seed"]));
+    FrameBuffer frameBuffer(std::stoul(options["width"]) / scale, std::stoul(options["height"]) / scale);
+    Renderer renderer(1);
+
+    // The path only visits odd cells, pillars stand on multiples of an even spacing, so the camera never ends up inside one.
+    CameraPath firstPath(map, frames);
+    int pillarSpacing = std::stoi(options["hall"]);
+    if (pillarSpacing > 0) {
+        pillarSpacing += pillarSpacing % 2;
+        for (int y = 1; y < map.getHeight() - 1; y++) {
+            for (int x = 1; x < map.getWidth() - 1; x++) map.setTile(x, y, x % pillarSpacing == 0 && y % pillarSpacing == 0 ? Wall : Empty);
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "isa      skip  Mrays/s   speedup  cells/ray  moves/ray  lookups/ray  identical" << std::endl;
+    std::vector<std::vector<WallColumn>> reference(frames), skipReference(frames);
+    double scalarTime = 0;
+    for (bool skipEmpty : {false, true}) {
+        renderer.setEmptySkipping(skipEmpty);
+        for (RayCastingIsa isa : {RayCastingIsa::Scalar, RayCastingIsa::AVX2, RayCastingIsa::AVX512}) {
+            if (!PacketCaster::isSupported(isa)) {
+                if (!skipEmpty) std::cout << std::left << std::setw(9) << PacketCaster::getName(isa) << "not supported" << std::right << std::endl;
+                continue;
+            }
+            renderer.setRayCastingIsa(isa);
+
+            CameraPath path = firstPath;
+            std::vector<WallColumn> columns;
+            bool identical = true;
+            double time = 0;
+            unsigned long long cells = 0, moves = 0, lookups = 0;
+            for (size_t frame = 0; frame < frames; frame++) {
+                auto start = std::chrono::steady_clock::now();
+                renderer.castColumns(frameBuffer, map, path.getX(), path.getY(), path.getAngle(), columns);
+                time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                // Every run hits what scalar casting without skipping hits, and does the lookups and moves scalar casting does with the same skipping.
+                if (isa == RayCastingIsa::Scalar && !skipEmpty) reference[frame] = columns;
+                if (isa == RayCastingIsa::Scalar) skipReference[frame] = columns;
+                for (size_t x = 0; x < columns.size(); x++) {
+                    identical = identical && sameHit(columns[x].hit, reference[frame][x].hit) && columns[x].textureColumn == reference[frame][x].textureColumn &&
+                                columns[x].hit.steps == skipReference[frame][x].hit.steps && columns[x].hit.moves == skipReference[frame][x].hit.moves;
+                    cells += columns[x].hit.cells;
+                    moves += columns[x].hit.moves;
+                    lookups += columns[x].hit.steps;
+                }
+                path.advance();
+            }
+            if (isa == RayCastingIsa::Scalar && !skipEmpty) scalarTime = time;
+
+            double rays = (double)(frames * frameBuffer.getLength());
+            std::cout << std::left << std::setw(9) << PacketCaster::getName(isa) << std::setw(6) << (skipEmpty ? "yes" : "no") << std::setw(10)
+                      << rays / time / 1e6 << std::setw(9) << scalarTime / time << std::setw(11) << (double)cells / rays << std::setw(11) << (double)moves / rays << std::setw(13)
+                      << (double)lookups / rays << (identical ? "yes" : "NO") << std::right << std::endl;
+            if (!identical) return 1;
+        }
+    }
+    return 0;
+}
+
+int benchMazeGeneration(std::map<std::string, std::string> &options) {
+    uint64_t seed = std::stoull(options["seed"]);
+    int repeat = std::stoi(options["repeat"]);
+    ThreadPool pool((unsigned int)std::stoul(options["threads"]));
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "threads: " << pool.getThreadCount() << std::endl;
+    std::cout << "size        iterative ms  recursive ms" << std::endl;
+    std::string sizes = options["sizes"];
+    for (size_t start = 0; start < sizes.size();) {
+        size_t end = std::min(sizes.find(',', start), sizes.size());
+        int size = std::stoi(sizes.substr(start, end - start));
+        size += 1 - size % 2; // Ensure odd dimensions
+        start = end + 1;
+
+        // Best of repeat runs, so page faults of the first allocation do not dominate.
+        double best[2] = {1e300, 1e300};
+        for (int run = 0; run < repeat; run++) {
+            for (MazeAlgorithm algorithm : {MazeAlgorithm::Iterative, MazeAlgorithm::Recursive}) {
+                srand((unsigned int)seed);
+                auto begin = std::chrono::steady_clock::now();
+                Map map(size, size, seed, algorithm, &pool);
+                double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+                double &slot = best[algorithm == MazeAlgorithm::Iterative ? 0 : 1];
+                slot = std::min(slot, time);
+            }
+        }
+        std::cout << std::left << std::setw(12) << size << std::setw(14) << best[0] << best[1] << std::right << std::endl;
+    }
+    return 0;
+}
+int benchSolver(std::map<std::string, std::string> &options) {
+    uint64_t seed = std::stoull(options["seed"]);
+    int repeat = std::stoi(options["repeat"]);
+    ThreadPool pool((unsigned int)std::stoul(options["threads"]));
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "size        solve ms      path cells    search MB" << std::endl;
+    std::string sizes = options["sizes"];
+    for (size_t start = 0; start < sizes.size();) {
+        size_t end = std::min(sizes.find(',', start), sizes.size());
+        int size = std::stoi(sizes.substr(start, end - start));
+        size += 1 - size % 2; // Ensure odd dimensions
+        start = end + 1;
+
+        Map map(size, size, seed, MazeAlgorithm::Iterative, &pool);
+        std::vector<uint32_t> path;
+        double best = 1e300;
+        for (int run = 0; run < repeat; run++) {
+            auto begin = std::chrono::steady_clock::now();
+            path = map.solve();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+        }
+
+        uint32_t width = (uint32_t)map.getWidth();
+        bool valid = !path.empty() && path.front() == width + 1 && path.back() == (uint32_t)(map.getHeight() - 2) * width + width - 2;
+        for (size_t i = 0; valid && i < path.size(); i++) {
+            uint32_t step = i ? (path[i] > path[i - 1] ? path[i] - path[i - 1] : path[i - 1] - path[i]) : 1;
+            valid = (step == 1 || step == width) && !map.isSolid((int)(path[i] % width), (int)(path[i] / width));
+        }
+        if (!valid) {
+            std::cerr << "Invalid path through the " << size << "x" << size << " maze" << std::endl;
+            return 1;
+        }
+
+        double cells = (double)map.getWidth() * (double)map.getHeight();
+        std::cout << std::left << std::setw(12) << size << std::setw(14) << best << std::setw(14) << path.size() << cells * 3 / 8 / 1048576 << std::right << std::endl;
+    }
+    return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    std::map<std::string, std::string> options = {
+        {"mode", "frames"}, {"width", "1280"}, {"height", "720"}, {"scale", "1"}, {"frames", "600"}, {"warmup", "30"},
+        {"maze", "51"}, {"seed", "1"}, {"threads", "0"}, {"ray-casting", "dda"}, {"chunked", "0"}, {"isa", "best"}, {"skip-empty", "1"}, {"planes", "1"},
+        {"mipmaps", "1"}, {"wall-texture", ""}, {"sprites", "0"}, {"camera", "path"}, {"screenshot", ""}, {"trace", ""},
+        {"sizes", "101,1001,3001,10001"}, {"repeat", "3"}, {"hall", "0"}};
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.rfind("--", 0) != 0 || !options.count(key.substr(2))) {
+            std::cerr << "Unknown option " << key << std::endl;
+            return 1;
+        }
+        options[key.substr(2)] = argv[i + 1];
+    }
+
+    if (options["mode"] == "maze") return benchMazeGeneration(options);
+    if (options["mode"] == "rays") return benchRayCasting(options);
+    if (options["mode"] == "solve") return benchSolver(options);
+
+    size_t scale = std::stoul(options["scale"]);
+    size_t length = std::stoul(options["width"]) / scale, height = std::stoul(options["height"]) / scale;
+    size_t frames = std::stoul(options["frames"]), warmup = std::stoul(options["warmup"]);
+    int mazeSize = std::stoi(options["maze"]);
+    mazeSize += 1 - mazeSize % 2; // Ensure odd dimensions
+
+    // A seeded maze makes the camera path repeatable.
+    Map map(mazeSize, mazeSize, std::stoull(options["seed"]), options["chunked"] == "1" ? MazeAlgorithm::Chunked : MazeAlgorithm::Iterative);
+    if (!options["wall-texture"].empty()) map.setWallTexture(options["wall-texture"]);
+    std::shared_ptr<const Texture> sky = TextureCache::get("../textures/skyTexture2P6.ppm");
+
+    std::optional<SpriteLayer> sprites;
+    size_t spriteCount = std::stoul(options["sprites"]);
+    if (spriteCount > 0 && !map.isChunked()) {
+        sprites.emplace();
+        std::mt19937_64 spriteRandom(std::stoull(options["seed"]));
+        while (sprites->size() < spriteCount) {
+            int x = (int)(spriteRandom() % (uint64_t)map.getWidth()), y = (int)(spriteRandom() % (uint64_t)map.getHeight());
+            if (!map.isSolid(x, y)) sprites->add((float)x + 0.5f, (float)y + 0.5f, Pickup);
+        }
+    }
+
+    FrameBuffer frameBuffer(length, height);
+    Renderer renderer((unsigned int)std::stoul(options["threads"]));
+    renderer.setRayCastingMode(options["ray-casting"] == "marching" ? RayCastingMode::Marching : RayCastingMode::DDA);
+    renderer.setRayCastingIsa(parseIsa(options["isa"]));
+    renderer.setEmptySkipping(options["skip-empty"] == "1");
+    renderer.setPlaneCasting(options["planes"] == "1");
+    renderer.setMipmapping(options["mipmaps"] == "1");
+
+    // The autopilot moves the player by two 120 Hz simulation ticks per frame, like the game at 60 frames per second.
+    CameraPath path(map, frames + warmup);
+    bool autopilotCamera = options["camera"] == "autopilot";
+    Player player;
+    Autopilot autopilot;
+    if (autopilotCamera) autopilot.follow(map, map.solve(), (float)map.getWidth() - 1.5f, (float)map.getHeight() - 1.1f);
+
+    std::vector<double> frameTimes;
+    unsigned long long totalRaySteps = 0, totalRayCells = 0, totalVisibleSprites = 0;
+    for (size_t frame = 0; frame < warmup + frames; frame++) {
+        PROFILE_SCOPE("frame");
+        float cameraX = autopilotCamera ? player.getX() : path.getX(), cameraY = autopilotCamera ? player.getY() : path.getY();
+        float cameraAngle = autopilotCamera ? player.getAngle() : path.getAngle();
+        auto start = std::chrono::steady_clock::now();
+        renderer.renderFrame(frameBuffer, map, *sky, cameraX, cameraY, cameraAngle, sprites ? &*sprites : nullptr);
+        auto end = std::chrono::steady_clock::now();
+
+        if (frame >= warmup) {
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            totalRaySteps += renderer.getRaySteps();
+            totalRayCells += renderer.getRayCells();
+            totalVisibleSprites += renderer.getVisibleSprites();
+        }
+        if (autopilotCamera) {
+            for (int tick = 0; tick < 2; tick++)
+                player.movement(autopilot.steer(player), 1000.f / 120.f, map);
+        } else {
+            path.advance();
+        }
+    }
+
+    double totalTime = 0;
+    for (double time : frameTimes)
+        totalTime += time;
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "resolution: " << length << "x" << height << " (scale " << scale << ")"
+              << ", threads: " << renderer.getThreadCount()
+              << ", maze: " << mazeSize << "x" << mazeSize << ", seed: " << options["seed"]
+              << ", ray casting: " << options["ray-casting"] << " (" << PacketCaster::getName(renderer.getRayCastingIsa()) << ")"
+              << ", floor: " << (options["planes"] == "1" ? "textured" : "flat")
+              << ", mipmaps: " << (options["mipmaps"] == "1" ? "on" : "off") << std::endl;
+    std::cout << "frames: " << frameTimes.size() << ", fps: " << 1000.0 * (double)frameTimes.size() / totalTime << std::endl;
+    std::cout << "frame time ms: mean " << totalTime / (double)frameTimes.size()
+              << ", p50 " << percentile(frameTimes, 0.5) << ", p99 " << percentile(frameTimes, 0.99)
+              << ", max " << frameTimes.back() << std::endl;
+    std::cout << "ray steps per frame: " << (double)totalRaySteps / (double)frameTimes.size()
+              << ", per ray: " << (double)totalRaySteps / (double)frameTimes.size() / (double)length
+              << ", cells per ray: " << (double)totalRayCells / (double)frameTimes.size() / (double)length << std::endl;
+    if (sprites)
+        std::cout << "sprites: " << sprites->size() << ", in view per frame: " << (double)totalVisibleSprites / (double)frameTimes.size() << std::endl;
+    if (!options["screenshot"].empty()) {
+        if (!writeScreenshot(frameBuffer, options["screenshot"])) {
+            std::cerr << "Cannot write " << options["screenshot"] << std::endl;
+            return 1;
+        }
+        std::cout << "last frame written to " << options["screenshot"] << std::endl;
+    }
+    if (map.isChunked())
+        std::cout << "chunks resident: " << map.getChunks()->getResidentChunks()
+                  << ", generated: " << map.getChunks()->getGeneratedChunks() << std::endl;
+
+#ifdef PROFILING
+    if (!options["trace"].empty() && Profiler::writeChromeTrace(options["trace"]))
+        std::cout << "trace written to " << options["trace"] << std::endl;
+#endif
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "camerapath.h"
+
+#include <cmath>
+
+CameraPath::CameraPath(const Map &map, size_t waypointCount, float cameraSpeed, float cameraAngularSpeed) {
+    speed = cameraSpeed;
+    angularSpeed = cameraAngularSpeed;
+
+    // Directions ordered clockwise, angle 0 is positive y and 90 positive x.
+    const int directionX[] = {0, 1, 0, -1}, directionY[] = {1, 0, -1, 0};
+    int cellX = 1, cellY = 1, direction = 0;
+
+    waypointsX.push_back(1.5f);
+    waypointsY.push_back(1.5f);
+    while (waypointsX.size() < waypointCount) {
+        // Prefer turning right, then going straight, left and finally back.
+        for (int turn : {1, 0, 3, 2}) {
+            int candidate = (direction + turn) % 4;
+            int nextX = cellX + directionX[candidate], nextY = cellY + directionY[candidate];
+            if (map.getTile(nextX, nextY) == Empty) {
+                direction = candidate;
+                cellX = nextX;
+                cellY = nextY;
+                break;
+            }
+        }
+        waypointsX.push_back((float)cellX + 0.5f);
+        waypointsY.push_back((float)cellY + 0.5f);
+    }
+
+    x = waypointsX.front();
+    y = waypointsY.front();
+    angle = 0.f;
+}
+
+void CameraPath::advance() {
+    if (nextWaypoint >= waypointsX.size()) return;
+
+    float dx = waypointsX[nextWaypoint] - x, dy = waypointsY[nextWaypoint] - y;
+    float targetAngle = atan2f(dx, dy) * 180.f / (float)M_PI;
+
+    // Turn towards the next waypoint before moving.
+    float turn = remainderf(targetAngle - angle, 360.f);
+    if (fabsf(turn) > angularSpeed) {
+        angle += turn > 0 ? angularSpeed : -angularSpeed;
+    } else {
+        angle = targetAngle;
+        float distance = sqrtf(dx * dx + dy * dy);
+        if (distance <= speed) {
+            x = waypointsX[nextWaypoint];
+            y = waypointsY[nextWaypoint];
+            nextWaypoint++;
+        } else {
+            x += dx / distance * speed;
+            y += dy / distance * speed;
+        }
+    }
+
+    // Normalise angle.
+    while (angle > 360)
+        angle -= 360;
+    while (angle < 0)
+        angle += 360;
+}
+
+float CameraPath::getX() { return x; }
+float CameraPath::getY() { return y; }
+float CameraPath::getAngle() { return angle; }
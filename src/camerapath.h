@@ -0,0 +1,28 @@
+#ifndef camerapathH
+#define camerapathH
+
+#include <vector>
+
+#include "map.h"
+
+// Deterministic camera path through a generated maze, used to replay the same views in benchmarks.
+// The camera follows the right hand wall from the starting cell, turning in place at corners.
+class CameraPath {
+    std::vector<float> waypointsX, waypointsY;
+    size_t nextWaypoint = 1;
+    float x, y, angle;
+    float speed, angularSpeed;
+
+public:
+    // Walks waypointCount cells of map, cameraSpeed is in tiles and cameraAngularSpeed in degrees per frame.
+    CameraPath(const Map &map, size_t waypointCount, float cameraSpeed = 0.08f, float cameraAngularSpeed = 6.f);
+
+    // Move the camera by one frame.
+    void advance();
+
+    float getX();
+    float getY();
+    float getAngle();
+};
+
+#endif
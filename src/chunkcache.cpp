@@ -0,0 +1,112 @@
+#include "chunkcache.h"
+
+#include <algorithm>
+
+#include "mazegenerator.h"
+#include "random.h"
+#include "walldistances.h"
+
+std::atomic<uint64_t> ChunkCache::nextId{1};
+
+ChunkCache::ChunkCache(int mazeWidth, int mazeHeight, uint64_t mazeSeed, size_t residentCapacity) {
+    width = mazeWidth;
+    height = mazeHeight;
+    seed = mazeSeed;
+    capacity = std::max(residentCapacity, (size_t)1);
+    id = nextId++;
+}
+
+size_t ChunkCache::getResidentChunks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return resident.size();
+}
+
+uint64_t ChunkCache::getGeneratedChunks() const { return generatedChunks.load(); }
+
+const ChunkCache::Chunk &ChunkCache::getChunk(int chunkX, int chunkY) const {
+    // Rays and the player mostly stay within a few chunks, remembering them avoids the lock.
+    // A remembered chunk stays alive even when the cache drops it.
+    struct RecentChunk {
+        uint64_t owner = 0;
+        int x = 0, y = 0;
+        std::shared_ptr<const Chunk> chunk;
+    };
+    thread_local std::array<RecentChunk, 8> recentChunks;
+
+    RecentChunk &recent = recentChunks[(size_t)(chunkX * 3 + chunkY) & 7];
+    if (recent.owner != id || recent.x != chunkX || recent.y != chunkY) {
+        recent.chunk = loadChunk(chunkX, chunkY);
+        recent.owner = id;
+        recent.x = chunkX;
+        recent.y = chunkY;
+    }
+    return *recent.chunk;
+}
+
+std::shared_ptr<const ChunkCache::Chunk> ChunkCache::loadChunk(int chunkX, int chunkY) const {
+    uint64_t key = (uint64_t)(uint32_t)chunkX << 32 | (uint32_t)chunkY;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = resident.find(key);
+        if (it != resident.end()) {
+            loadOrder.splice(loadOrder.end(), loadOrder, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    // Generate outside the lock, two threads racing for the same chunk produce identical copies.
+    std::shared_ptr<const Chunk> chunk = generateChunk(chunkX, chunkY);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = resident.find(key);
+    if (it != resident.end()) return it->second.first;
+
+    while (resident.size() >= capacity) {
+        resident.erase(loadOrder.front());
+        loadOrder.pop_front();
+    }
+    loadOrder.push_back(key);
+    resident.emplace(key, std::make_pair(chunk, std::prev(loadOrder.end())));
+    return chunk;
+}
+
+std::shared_ptr<const ChunkCache::Chunk> ChunkCache::generateChunk(int chunkX, int chunkY) const {
+    generatedChunks++;
+    auto chunk = std::make_shared<Chunk>();
+    chunk->tiles.fill(Wall);
+
+    // Chunk coordinates are even, so local coordinates keep the parity maze generation relies on.
+    int originX = chunkX * chunkSize, originY = chunkY * chunkSize;
+
+    // Last cells inside the outer walls, in local coordinates.
+    int lastX = std::min(chunkSize - 1, width - 2 - originX), lastY = std::min(chunkSize - 1, height - 2 - originY);
+    if (originX >= 0 && originY >= 0 && lastX >= 1 && lastY >= 1) {
+        for (int y = 1; y <= lastY; y++) {
+            std::fill(&chunk->tiles[(size_t)(y * chunkSize + 1)], &chunk->tiles[(size_t)(y * chunkSize + lastX + 1)], (uint8_t)Empty);
+        }
+
+        uint64_t chunkSeed = seed + 0x9e3779b97f4a7c15ull * ((uint64_t)(uint32_t)chunkX << 32 | (uint32_t)chunkY);
+        Random random(chunkSeed);
+        MazeGenerator::generate(chunk->tiles.data(), chunkSize, {1, 1, lastX, lastY}, random.next());
+
+        // One hole at an odd coordinate in the left and top walls, except on the outer walls.
+        if (chunkX > 0) chunk->tiles[(size_t)((1 + 2 * random.inRange(0, (lastY - 1) / 2)) * chunkSize)] = Empty;
+        if (chunkY > 0) chunk->tiles[(size_t)(1 + 2 * random.inRange(0, (lastX - 1) / 2))] = Empty;
+    }
+
+    // Entrance and exit of the whole maze, the exit can be in a chunk holding only the bottom wall.
+    if (chunkX == 0 && chunkY == 0) chunk->tiles[1] = Entrance;
+    int exitX = width - 2 - originX, exitY = height - 1 - originY;
+    if (exitX >= 0 && exitX < chunkSize && exitY >= 0 && exitY < chunkSize)
+        chunk->tiles[(size_t)(exitY * chunkSize + exitX)] = Exit;
+
+    for (size_t word = 0; word < chunk->solid.size(); word++) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 64; i++) {
+            bits |= (uint64_t)(chunk->tiles[word * 64 + i] != Empty) << i;
+        }
+        chunk->solid[word] = bits;
+    }
+    WallDistances::compute(chunk->tiles.data(), chunkSize, chunkSize, chunkSize, 0, 0, chunkSize, chunkSize, chunk->distances.data(), chunkSize);
+    return chunk;
+}
@@ -0,0 +1,77 @@
+#ifndef chunkcacheH
+#define chunkcacheH
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Maze split into square chunks which are generated from a seed the first time a ray or the player touches them.
+// At most capacity chunks stay resident, the least recently loaded ones are dropped and regenerated when needed again,
+// so memory does not grow with the maze. Every chunk is its own maze, its top and left walls have one hole each
+// leading into the neighbouring chunks, which keeps the whole maze connected. Safe to read from several threads.
+class ChunkCache {
+public:
+    static constexpr int chunkShift = 6, chunkSize = 1 << chunkShift; // Must be even.
+
+    // Tiles, occupancy bits and WallDistances of one chunk, row after row. Distances count the chunk's edges as walls.
+    struct Chunk {
+        std::array<uint8_t, chunkSize * chunkSize> tiles;
+        std::array<uint64_t, chunkSize * chunkSize / 64> solid;
+        std::array<uint16_t, chunkSize * chunkSize> distances;
+    };
+
+private:
+    int width, height; // Whole maze including its outer walls, both odd.
+    uint64_t seed;
+    size_t capacity;
+    uint64_t id; // Tells apart chunks remembered by threads for different caches.
+
+    mutable std::mutex mutex;
+    mutable std::list<uint64_t> loadOrder; // Resident chunk keys, least recently loaded first.
+    mutable std::unordered_map<uint64_t, std::pair<std::shared_ptr<const Chunk>, std::list<uint64_t>::iterator>> resident;
+    mutable std::atomic<uint64_t> generatedChunks{0};
+
+    static std::atomic<uint64_t> nextId;
+
+public:
+    // width and height of the maze with its outer walls, both must be odd.
+    ChunkCache(int width, int height, uint64_t seed, size_t capacity);
+
+    ChunkCache(const ChunkCache &) = delete;
+    ChunkCache &operator=(const ChunkCache &) = delete;
+
+    uint8_t getTile(int x, int y) const {
+        const Chunk &chunk = getChunk(x >> chunkShift, y >> chunkShift);
+        return chunk.tiles[(size_t)((y & (chunkSize - 1)) * chunkSize + (x & (chunkSize - 1)))];
+    }
+
+    bool isSolid(int x, int y) const {
+        const Chunk &chunk = getChunk(x >> chunkShift, y >> chunkShift);
+        size_t idx = (size_t)((y & (chunkSize - 1)) * chunkSize + (x & (chunkSize - 1)));
+        return chunk.solid[idx >> 6] >> (idx & 63) & 1;
+    }
+
+    uint16_t getWallDistances(int x, int y) const {
+        const Chunk &chunk = getChunk(x >> chunkShift, y >> chunkShift);
+        return chunk.distances[(size_t)((y & (chunkSize - 1)) * chunkSize + (x & (chunkSize - 1)))];
+    }
+
+    size_t getResidentChunks() const;
+
+    // Chunks generated so far, including ones generated again after being dropped.
+    uint64_t getGeneratedChunks() const;
+
+private:
+    // Looks in a few chunks remembered by the calling thread before locking the cache.
+    const Chunk &getChunk(int chunkX, int chunkY) const;
+
+    std::shared_ptr<const Chunk> loadChunk(int chunkX, int chunkY) const;
+
+    std::shared_ptr<const Chunk> generateChunk(int chunkX, int chunkY) const;
+};
+
+#endif
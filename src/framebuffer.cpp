@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include "framebuffer.h"
+
+FrameBuffer::FrameBuffer() {
+    gameLength = gameHeight = 0;
+}
+
+FrameBuffer::FrameBuffer(size_t length, size_t height) {
+    gameLength = length;
+    gameHeight = height;
+    pixels = std::vector<Pixel>(gameLength * gameHeight, toPixel(sf::Color::Black));
+}
+
+void FrameBuffer::resize(size_t length, size_t height) {
+    gameLength = length;
+    gameHeight = height;
+    pixels.resize(gameLength * gameHeight);
+}
+
+size_t FrameBuffer::getLength() const { return gameLength; }
+size_t FrameBuffer::getHeight() const { return gameHeight; }
+const Pixel *FrameBuffer::getPixels() const { return pixels.data(); }
+
+// Set the color of a simulation pixel
+void FrameBuffer::setGamePixelColor(int x, int y, const sf::Color &color) {
+    setGamePixel(x, y, toPixel(color));
+}
+
+void FrameBuffer::setGamePixel(int x, int y, Pixel pixel) {
+    if (x < 0 || (size_t)x >= gameLength || y < 0 || (size_t)y >= gameHeight) return;
+
+    // Flip vertical orientation.
+    pixels[(gameHeight - y - 1) * gameLength + x] = pixel;
+}
+
+// Draw a vertical line.
+void FrameBuffer::drawVericalLine(int y1, int y2, int x, const sf::Color &color) {
+    drawVericalLine(y1, y2, x, toPixel(color));
+}
+
+void FrameBuffer::drawVericalLine(int y1, int y2, int x, Pixel pixel) {
+    if (y1 > y2) std::swap(y1, y2);
+    y1 = std::max(y1, 0);
+    y2 = std::min(y2, (int)gameHeight - 1);
+    if (x < 0 || (size_t)x >= gameLength || y1 > y2) return;
+
+    // Clipped once for the whole line, rows are stored from the top so going up the screen steps back one row.
+    Pixel *pPixels = pixels.data();
+    size_t idx = (gameHeight - (size_t)y1 - 1) * gameLength + (size_t)x;
+    for (int y = y1; y <= y2; y++, idx -= gameLength) {
+        pPixels[idx] = pixel;
+    }
+}
+
+// Each image row is expanded into one frame row, which is then copied to the other rows of its blocks.
+void FrameBuffer::drawScaledImage(int x, int y, const Pixel *image, size_t stride, size_t width, size_t height, int scale) {
+    int x1 = std::max(x, 0), x2 = std::min(x + (int)width * scale, (int)gameLength);
+    if (x1 >= x2 || scale <= 0) return;
+
+    Pixel *pPixels = pixels.data();
+    for (size_t row = 0; row < height; row++) {
+        int y1 = std::max(y + (int)row * scale, 0), y2 = std::min(y + ((int)row + 1) * scale, (int)gameHeight);
+        if (y1 >= y2) continue;
+
+        Pixel *pFirstRow = pPixels + (gameHeight - (size_t)y1 - 1) * gameLength;
+        const Pixel *pImageRow = image + row * stride;
+        for (int px = x1; px < x2; px++) {
+            pFirstRow[px] = pImageRow[(px - x) / scale];
+        }
+        for (int py = y1 + 1; py < y2; py++) {
+            std::copy(pFirstRow + x1, pFirstRow + x2, pPixels + (gameHeight - (size_t)py - 1) * gameLength + x1);
+        }
+    }
+}
+
+// Texel positions are 16.16 fixed point, advanced by one step per pixel going up.
+void FrameBuffer::drawTexelSpan(size_t x, int y1, int y2, std::span<const Pixel> texels, float firstTexel, float texelsPerPixel) {
+    if (y1 > y2) return;
+    float maxPosition = (float)(texels.size() << 16);
+    uint32_t position = (uint32_t)std::clamp(firstTexel * 65536.f, 0.f, maxPosition);
+    uint32_t step = (uint32_t)std::min(texelsPerPixel * 65536.f, maxPosition);
+    const Pixel *pTexels = texels.data();
+
+    // Rows past the last texel repeat it. They are counted once, so the loop over the others needs no bounds check.
+    size_t rows = (size_t)(y2 - y1) + 1;
+    uint64_t end = (uint64_t)texels.size() << 16;
+    size_t inside = position >= end ? 0 : step == 0 ? rows : std::min(rows, (size_t)((end - position + step - 1) / step));
+
+    // Rows are stored from the top, so going up the screen steps back one row.
+    Pixel *pPixels = pixels.data();
+    size_t idx = (gameHeight - (size_t)y1 - 1) * gameLength + x;
+    for (size_t row = 0; row < inside; row++, idx -= gameLength, position += step) {
+        pPixels[idx] = pTexels[position >> 16];
+    }
+    for (size_t row = inside; row < rows; row++, idx -= gameLength) {
+        pPixels[idx] = texels.back();
+    }
+}
+
+WallRows FrameBuffer::getWallRows(float wallHeight) const {
+    int lastRow = (int)gameHeight - 1;
+    float wallCenter = (float)(gameHeight / 2);
+    WallRows rows = {std::max((int)roundf(wallCenter - wallHeight), 0), std::min((int)ceilf(wallCenter + wallHeight), lastRow)};
+    if (rows.first > rows.last) rows.first = rows.last = lastRow + 1; // Too small to cover a pixel.
+    return rows;
+}
+
+// Spans are clipped once per column, then filled bottom to top. A wall texel i starts at the pixel nearest to
+// wallBottom + i * texelSize, like texels drawn as separate lines did.
+void FrameBuffer::drawColumns(size_t firstX, const ColumnSpans *columns, size_t count, const Pixel *pFloorPixel) {
+    if (firstX >= gameLength) return;
+    count = std::min({count, maxColumns, gameLength - firstX});
+
+    int lastRow = (int)gameHeight - 1;
+    float halfHeight = (float)gameHeight / 2.f, wallCenter = (float)(gameHeight / 2);
+    int skyFirst = getHorizonRow();
+
+    for (size_t i = 0; i < count; i++) {
+        const ColumnSpans &column = columns[i];
+        size_t x = firstX + i;
+        float skyTexelsPerPixel = (float)column.skyTexels.size() / ((float)gameHeight + 2.f - halfHeight);
+
+        float wallBottom = wallCenter - column.wallHeight;
+        float wallTexelsPerPixel = (float)column.wallTexels.size() / (2.f * column.wallHeight);
+        auto [wallFirst, wallLast] = getWallRows(column.wallHeight);
+
+        // Floor and sky below the wall, the wall, then sky above it. Walls are centered on the horizon,
+        // so there is never floor above one.
+        int floorLast = std::min(wallFirst, skyFirst) - 1;
+        if (floorLast >= 0 && pFloorPixel) drawVericalLine(0, floorLast, (int)x, *pFloorPixel);
+        drawTexelSpan(x, wallFirst, wallLast, column.wallTexels, ((float)wallFirst + 0.5f - wallBottom) * wallTexelsPerPixel, wallTexelsPerPixel);
+        if (column.skyTexels.empty()) continue;
+        int skyStart = std::max(skyFirst, 0);
+        drawTexelSpan(x, skyStart, wallFirst - 1, column.skyTexels, ((float)skyStart + 0.5f - halfHeight) * skyTexelsPerPixel, skyTexelsPerPixel);
+        skyStart = std::max(skyFirst, wallLast + 1);
+        drawTexelSpan(x, skyStart, lastRow, column.skyTexels, ((float)skyStart + 0.5f - halfHeight) * skyTexelsPerPixel, skyTexelsPerPixel);
+    }
+}
+
+// Stepped like drawTexelSpan, only opaque texels are written.
+void FrameBuffer::drawSpriteColumn(size_t x, float bottom, float spriteHeight, std::span<const Pixel> texels, Pixel transparent) {
+    int first = std::max((int)roundf(bottom), 0), last = std::min((int)ceilf(bottom + spriteHeight) - 1, (int)gameHeight - 1);
+    if (x >= gameLength || first > last) return;
+
+    float texelsPerPixel = (float)texels.size() / spriteHeight, maxPosition = (float)(texels.size() << 16);
+    uint32_t position = (uint32_t)std::clamp(((float)first + 0.5f - bottom) * texelsPerPixel * 65536.f, 0.f, maxPosition);
+    uint32_t step = (uint32_t)std::min(texelsPerPixel * 65536.f, maxPosition);
+    size_t lastTexel = texels.size() - 1;
+    const Pixel *pTexels = texels.data();
+
+    Pixel *pPixels = pixels.data();
+    size_t idx = (gameHeight - (size_t)first - 1) * gameLength + x;
+    for (int y = first; y <= last; y++, idx -= gameLength, position += step) {
+        Pixel texel = pTexels[std::min((size_t)(position >> 16), lastTexel)];
+        if (texel != transparent) pPixels[idx] = texel;
+    }
+}
+
+// Texel coordinates are the fractional parts of the world position, so the texture repeats once per cell.
+// The whole row is contiguous in memory, only columns hidden behind walls are skipped.
+void FrameBuffer::drawPlaneRow(int y, const PlaneRow &row, const float *tangents, const int *rowLimits, std::span<const Pixel> texels, uint32_t width, uint32_t height) {
+    if (y < 0 || (size_t)y >= gameHeight) return;
+    float texelsX = (float)width, texelsY = (float)height;
+    size_t lastColumn = width - 1, lastTexel = height - 1;
+    const Pixel *pTexels = texels.data();
+    Pixel *pRow = pixels.data() + (gameHeight - (size_t)y - 1) * gameLength;
+    bool floor = y < getHorizonRow();
+
+    // Power of two textures wrap with masks, and scaling by their size is exact, so the texel is found
+    // without taking the fraction first and without clamping.
+    if (std::has_single_bit(width) && std::has_single_bit(height)) {
+        int64_t widthMask = width - 1, heightMask = height - 1;
+        int heightShift = std::countr_zero(height);
+        for (size_t x = 0; x < gameLength; x++) {
+            if (floor ? y > rowLimits[x] : y < rowLimits[x]) continue;
+            float worldX = row.originX + tangents[x] * row.stepX, worldY = row.originY + tangents[x] * row.stepY;
+            int64_t column = (int64_t)floorf(worldX * texelsX) & widthMask, texel = (int64_t)floorf(worldY * texelsY) & heightMask;
+            pRow[x] = pTexels[column << heightShift | texel];
+        }
+        return;
+    }
+
+    for (size_t x = 0; x < gameLength; x++) {
+        if (floor ? y > rowLimits[x] : y < rowLimits[x]) continue;
+        float worldX = row.originX + tangents[x] * row.stepX, worldY = row.originY + tangents[x] * row.stepY;
+        size_t column = std::min((size_t)((worldX - floorf(worldX)) * texelsX), lastColumn);
+        size_t texel = std::min((size_t)((worldY - floorf(worldY)) * texelsY), lastTexel);
+        pRow[x] = pTexels[column * height + texel];
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef framebufferH
+#define framebufferH
+
+#include <cmath>
+#include <vector>
+
+#include "pixel.h"
+#include "texture.h"
+
+// What one screen column shows.
+struct ColumnSpans {
+    float wallHeight;                   // Half of the wall height on screen, in game pixels.
+    std::span<const Pixel> wallTexels;  // Wall texture column, from the bottom.
+    std::span<const Pixel> skyTexels;   // Sky texture column, from the bottom, empty to leave the sky for a ceiling.
+};
+
+// Rows of one screen column covered by its wall, first > last when it covers none.
+struct WallRows {
+    int first, last;
+};
+
+// Floor or ceiling seen along one screen row. Column x shows the point
+// (originX + tangents[x] * stepX, originY + tangents[x] * stepY) in cells, where tangents[x] is the tangent
+// of the column's angle from the view direction, so the row is walked with two multiply adds per pixel.
+struct PlaneRow {
+    float originX, originY; // Point seen straight ahead.
+    float stepX, stepY;     // Per unit of tangent, the view's right vector scaled by the row's distance.
+};
+
+// Frame in memory at game resolution, drawn into by the renderer and shown by Window or read by benchmarks.
+class FrameBuffer {
+    size_t gameLength, gameHeight;
+    std::vector<Pixel> pixels; // Rows stored top to bottom.
+
+public:
+    FrameBuffer();
+
+    FrameBuffer(size_t length, size_t height);
+
+    // Change the frame size, contents are undefined afterwards. Does not reallocate while the frame
+    // is no bigger than the largest size it had, so the resolution can change between frames without a hitch.
+    void resize(size_t length, size_t height);
+
+    size_t getLength() const;
+    size_t getHeight() const;
+
+    // Packed RGBA pixels, rows from the top of the screen.
+    const Pixel *getPixels() const;
+
+    // Set the color of a simulation pixel, y grows up the screen. Pixels outside the frame are ignored.
+    void setGamePixelColor(int x, int y, const sf::Color &color);
+    void setGamePixel(int x, int y, Pixel pixel);
+
+    // Draw a vertical line, clipped to the frame.
+    void drawVericalLine(int y1, int y2, int x, const sf::Color &color);
+    void drawVericalLine(int y1, int y2, int x, Pixel pixel);
+
+    // Draw an image of width x height pixels, rows from the bottom stride pixels apart, with its bottom left corner
+    // at (x, y). Every image pixel covers a scale x scale block, clipped to the frame.
+    void drawScaledImage(int x, int y, const Pixel *image, size_t stride, size_t width, size_t height, int scale);
+
+    // Columns drawn by one drawColumns call, one cache line of pixels per row.
+    static constexpr size_t maxColumns = 16;
+
+    // First row of sky, rows below it show floor.
+    int getHorizonRow() const { return (int)roundf((float)gameHeight / 2.f); }
+
+    // Rows covered by a wall wallHeight pixels above and below the middle row.
+    WallRows getWallRows(float wallHeight) const;
+
+    // Draw up to maxColumns adjacent screen columns starting at firstX. Each shows floor up to the horizon, sky above it
+    // and its wall texture column centered vertically, wallHeight pixels above and below the middle row.
+    // Every pixel is written exactly once, textures are stepped in 16.16 fixed point.
+    // Without pFloorPixel the floor is left for drawPlaneRow, and so is the sky of columns without sky texels.
+    void drawColumns(size_t firstX, const ColumnSpans *columns, size_t count, const Pixel *pFloorPixel);
+
+    // Draw row y of a floor (below the horizon) or ceiling (above it) with a texture of width x height texels,
+    // column after column like Texture. Only columns whose wall, given by rowLimits, does not cover row y are drawn:
+    // rowLimits[x] is the last floor row of column x, or the first ceiling row.
+    void drawPlaneRow(int y, const PlaneRow &row, const float *tangents, const int *rowLimits, std::span<const Pixel> texels, uint32_t width, uint32_t height);
+
+    // Draw a sprite's texture column texels over column x, from row bottom up for spriteHeight pixels,
+    // leaving out texels equal to transparent. Clipped to the frame.
+    void drawSpriteColumn(size_t x, float bottom, float spriteHeight, std::span<const Pixel> texels, Pixel transparent);
+
+private:
+    // Draw rows y1 to y2 of column x with texels, starting at texel firstTexel and advancing texelsPerPixel per row.
+    void drawTexelSpan(size_t x, int y1, int y2, std::span<const Pixel> texels, float firstTexel, float texelsPerPixel);
+};
+#endif
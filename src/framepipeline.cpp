@@ -0,0 +1,48 @@
+#include "framepipeline.h"
+
+FramePipeline::FramePipeline(size_t length, size_t height) {
+    for (FrameBuffer &buffer : buffers) buffer = FrameBuffer(length, height);
+}
+
+FrameBuffer &FramePipeline::getBackBuffer() { return buffers[back]; }
+
+void FramePipeline::setInputTime(std::chrono::steady_clock::time_point time) { inputTimes[back] = time; }
+
+std::chrono::steady_clock::time_point FramePipeline::getInputTime() const { return inputTimes[front]; }
+
+bool FramePipeline::publish() {
+    // Only acquire clears freshBit, so once it is clear the waiting buffer is free to swap with.
+    // Compare and swap, so a concurrent close is never overwritten.
+    unsigned int state = waiting.load(std::memory_order_acquire);
+    while (!(state & closedBit)) {
+        if (state & freshBit) {
+            waiting.wait(state, std::memory_order_acquire);
+            state = waiting.load(std::memory_order_acquire);
+        } else if (waiting.compare_exchange_weak(state, back | freshBit, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            back = state & indexMask;
+            waiting.notify_one();
+            return true;
+        }
+    }
+    return false;
+}
+
+const FrameBuffer *FramePipeline::acquire() {
+    unsigned int state = waiting.load(std::memory_order_acquire);
+    while (!(state & closedBit)) {
+        if (!(state & freshBit)) {
+            waiting.wait(state, std::memory_order_acquire);
+            state = waiting.load(std::memory_order_acquire);
+        } else if (waiting.compare_exchange_weak(state, front, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            front = state & indexMask;
+            waiting.notify_one();
+            return &buffers[front];
+        }
+    }
+    return nullptr;
+}
+
+void FramePipeline::close() {
+    waiting.fetch_or(closedBit, std::memory_order_acq_rel);
+    waiting.notify_all();
+}
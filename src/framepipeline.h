@@ -0,0 +1,50 @@
+#ifndef framepipelineH
+#define framepipelineH
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "framebuffer.h"
+
+// Triple buffered hand-off of frames from a render thread to the presenting thread, without locks.
+// The render thread draws into the back buffer while the presenting thread shows the front one, and a finished
+// frame waits in between. publish waits while that frame has not been taken, so at most one frame queues up.
+class FramePipeline {
+    static constexpr unsigned int indexMask = 3;
+    static constexpr unsigned int freshBit = 4;  // The waiting frame has not been taken yet.
+    static constexpr unsigned int closedBit = 8;
+
+    std::array<FrameBuffer, 3> buffers;
+    std::array<std::chrono::steady_clock::time_point, 3> inputTimes{}; // Of each buffer's frame, see setInputTime.
+    std::atomic<unsigned int> waiting{2}; // Index of the buffer between back and front, with the bits above.
+    unsigned int back = 0, front = 1;          // Only touched by the render and presenting thread respectively.
+
+public:
+    // Buffers are allocated for length x height, they can be resized to anything smaller without reallocating.
+    FramePipeline(size_t length, size_t height);
+
+    FramePipeline(const FramePipeline &) = delete;
+    FramePipeline &operator=(const FramePipeline &) = delete;
+
+    // Buffer the render thread draws the next frame into.
+    FrameBuffer &getBackBuffer();
+
+    // When the oldest input first shown by the back buffer's frame was read, the zero time point when it shows none.
+    void setInputTime(std::chrono::steady_clock::time_point time);
+
+    // Input time of the frame last returned by acquire.
+    std::chrono::steady_clock::time_point getInputTime() const;
+
+    // Hand the back buffer over, waiting while the previous frame has not been taken. Returns false once closed.
+    bool publish();
+
+    // Take the newest finished frame, waiting for one if it was taken already. Returns nullptr once closed.
+    // The frame stays valid until the next call.
+    const FrameBuffer *acquire();
+
+    // Make waiting and future publish and acquire calls fail.
+    void close();
+};
+
+#endif
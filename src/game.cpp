@@ -1,187 +1,342 @@
+#include<algorithm>
 #include<iostream>
 #include<chrono>
+#include<limits>
+#include<thread>
+#include<sys/resource.h>
 
 #include "game.h"
+#include "hud.h"
+#include "profiler.h"
+#include "texturecache.h"
 
 // Class representing game logic.
-Game::Game(size_t length, size_t height, int scale, int maze_x_starting_size, int maze_y_starting_size) {
-    trueLength = length;
-    trueHeight = height;
+Game::Game(size_t length, size_t height, int scale, int maze_x_starting_size, int maze_y_starting_size, unsigned int renderThreads, int minStreamedSize, bool smoothUpscale, float targetFrameMs) {
     gameLength = length / scale;
     gameHeight = height / scale;
-    pWindow = new Window(gameLength, gameHeight, scale, "Maze finder");
+    pWindow = new Window(gameLength, gameHeight, scale, "Maze finder", smoothUpscale);
+    pRenderer = new Renderer(renderThreads);
 
-    // Ensure odd dimensions
-    map = Map(maze_x_starting_size + 1 - (maze_x_starting_size % 2), maze_y_starting_size + 1 - (maze_y_starting_size % 2));
+    // Allocated once at window resolution, the most the controller can ask for.
+    pResolution = new ResolutionController(gameLength * (size_t)scale, gameHeight * (size_t)scale, 1.f / (float)scale, targetFrameMs);
+    pFrames = new FramePipeline(gameLength * (size_t)scale, gameHeight * (size_t)scale);
+    pFrameBuffer = &pFrames->getBackBuffer();
+    pFrameBuffer->resize(gameLength, gameHeight);
+    streamingMinSize = minStreamedSize;
 
-    sky = Texture("../textures/skyTexture2P3.ppm");
-    // sky = Texture("../textures/starry_night_sky.ppm");
+    // Ensure odd dimensions
+    map = generateMap(maze_x_starting_size + 1 - (maze_x_starting_size % 2), maze_y_starting_size + 1 - (maze_y_starting_size % 2), (uint64_t)rand());
 
-    helperWindowScale = std::max((int)std::min(length / 2 / map.getMap().front().size(), height / 2 / map.getMap().size()), 1); // scale to main window.
-}
+    sprites = placeSprites(map);
+    sky = TextureCache::get("../textures/skyTexture2P6.ppm");
+    // sky = TextureCache::get("../textures/starry_night_sky.ppm");
 
-void Game::changeSkyTexture(std::string filePath) {
-    sky = Texture(filePath);
+    updateHelperWindowScale();
+    prefetchNextLevel();
 }
 
-void Game::renderFrameToBuffer() {
-    // For each pixel in screen width cast a ray to a corresponding angle in fov range and extend
-    // until it hits a wall, then calculate necessary wall height
+const ResolutionController &Game::getResolution() const { return *pResolution; }
 
-    // Use getters only once
-    float playerX = player.getX(), playerY = player.getY(), playerAngle = player.getAngle();
+void Game::applyResolution() {
+    gameLength = pResolution->getLength();
+    gameHeight = pResolution->getHeight();
+    updateHelperWindowScale();
+}
 
-    // Rays range from playerAngle - (fov / 2) to playerAngle + (fov / 2)
-    float rayAngle = playerAngle - (float)fov / 2.f;
+void Game::updateHelperWindowScale() {
+    helperWindowScale = std::max((int)std::min(gameLength / 2 / (size_t)map.getWidth(), gameHeight / 2 / (size_t)map.getHeight()), 1); // scale to main window.
+}
 
-    float incrimentAngle = (float)fov / (float)gameLength;
+void Game::changeSkyTexture(std::string filePath) {
+    sky = TextureCache::get(filePath);
+}
 
-    float halfHeight = (float)gameHeight / 2.f;
+void Game::setRayCastingMode(RayCastingMode mode) {
+    pRenderer->setRayCastingMode(mode);
+}
 
-    const std::vector<std::vector<int>> &mapArray = map.getMap();
+void Game::setAutopilot(bool enabled) {
+    bool wasEnabled = autopilotEnabled.exchange(enabled);
+    if (!enabled) return;
+    followPath(map.solve());
+
+    // The level being prefetched was started without a solution, solve it in the background as well.
+    if (!wasEnabled && nextLevel.valid()) {
+        nextLevel = std::async(std::launch::async, [pending = std::move(nextLevel)]() mutable {
+            PROFILE_SCOPE("solve prefetched level");
+            Level level = pending.get();
+            if (level.solution.empty()) level.solution = level.map.solve();
+            return level;
+        });
+    }
+}
 
-    for (unsigned int rayCount = 0; rayCount < gameLength; rayCount++) {
-        // Normalise rayAngle.
-        while (rayAngle > 360)
-            rayAngle -= 360;
-        while (rayAngle < 0)
-            rayAngle += 360;
+void Game::followPath(const std::vector<uint32_t> &path) {
+    // The player solves the maze in the top row of the cell in front of the exit.
+    autopilot.follow(map, path, (float)map.getWidth() - 1.5f, (float)map.getHeight() - 1.1f);
+}
 
-        float rayX = playerX, rayY = playerY; // Ray starts from the player.
+void Game::setRenderAhead(int frames) {
+    renderAhead = std::clamp(frames, 0, 1);
+}
 
-        // Calculate ray increments in x, y coordinates
-        float rayCosIncrement = cosf(degreesToRadians(rayAngle)) / (float)rayCastingPrecision;
-        float raySinIncrement = sinf(degreesToRadians(rayAngle)) / (float)rayCastingPrecision;
+InputLatency Game::getInputLatency() const {
+    std::lock_guard<std::mutex> lock(latencyMutex);
+    if (inputLatencies.empty()) return {0, 0, 0, 0};
 
-        // Wall collision check.
-        bool hitWall = false, hitFromX;
-        while (!hitWall) {
-            // Necessary for calculating texture orientation.
-            hitFromX = mapArray[(int)rayY][(int)(rayX + raySinIncrement)];
+    std::vector<float> sorted(inputLatencies.begin(), inputLatencies.end());
+    std::sort(sorted.begin(), sorted.end());
+    float total = 0;
+    for (float latency : sorted)
+        total += latency;
+    return {total / (float)sorted.size(), sorted[sorted.size() / 2], sorted[(sorted.size() - 1) * 99 / 100], sorted.size()};
+}
 
-            // 0 degrees is positive y, 90 degrees positive x
-            // so the angle to x if 90 - playerAngle, which flips sin and cos
-            rayX += raySinIncrement;
-            rayY += rayCosIncrement;
+void Game::addInputLatency(float latencyMs) {
+    std::lock_guard<std::mutex> lock(latencyMutex);
+    inputLatencies.push_back(latencyMs);
+    if (inputLatencies.size() > latencySamples) inputLatencies.pop_front();
+}
 
-            hitWall = mapArray[(int)rayY][(int)rayX];
-        }
+void Game::renderFrameToBuffer() {
+    pRenderer->renderFrame(*pFrameBuffer, map, *sky, camera.getX(), camera.getY(), camera.getAngle(), &sprites);
+}
 
-        // Calculate distance to wall using Pythagoreas theorem
-        float distanceToWall = sqrtf(fabsf(playerX - rayX) * fabsf(playerX - rayX) + fabsf(playerY - rayY) * fabsf(playerY - rayY));
-
-        // Fisheye fix, normalise to playerAngle vector
-        distanceToWall *= cosf(degreesToRadians(rayAngle - playerAngle));
-
-        float wallHeight = halfHeight / distanceToWall;
-
-        // Load wall texture
-        Texture &t = map.getTexture((int)rayX, (int)rayY);
-
-        // Calculate which vertical strip of the texture to use
-        // By multiplying a coordinate by texture width, we get it's equivalent
-        // in a map made of texture pixels, then by taking the modulus
-        // we get which pixel strip in texture.
-        // One of rayX and rayY is close to edge, so it doesn't affect the chosen coordinate
-
-        int textureVerticalSlipIdx;
-        int textureWidth = (int)t.getWidth();
-        if (!hitFromX) {
-            textureVerticalSlipIdx = (int)roundf((float)textureWidth * rayX) % textureWidth;
-            // Flip the textures when necessary.
-            if (roundf(rayY) > floorf(rayY)) textureVerticalSlipIdx = textureWidth - textureVerticalSlipIdx - 1;
-        } else {
-            textureVerticalSlipIdx = (int)roundf((float)textureWidth * rayY) % textureWidth;
-            // Flip the textures when necessary.
-            if (roundf(rayX) <= floorf(rayX)) textureVerticalSlipIdx = textureWidth - textureVerticalSlipIdx - 1;
-        }
+void Game::renderHelperWindow() {
+    if (!helperVisibility) return;
+    PROFILE_SCOPE("minimap");
 
+    minimap.draw(*pFrameBuffer, map, camera.getX(), camera.getY(), helperWindowScale, (int)gameLength / 2 / helperWindowScale, (int)gameHeight / 2 / helperWindowScale);
+}
 
-        // Draw floor.
-        pWindow->drawVericalLine(0, (int)halfHeight, rayCount, sf::Color(121, 121, 121, 255));
+#ifdef PROFILING
+void Game::renderProfilerHud() {
+    if (!hudVisibility) return;
+
+    int scale = std::max((int)gameHeight / 360, 1), y = 0;
+    char line[64];
+    Hud::drawText(*pFrameBuffer, 0, y, "stage          mean   p50   p99 ms", sf::Color::Yellow, scale);
+    for (const StageStats &stats : Profiler::getStageStats()) {
+        y += Hud::getLineHeight(scale);
+        snprintf(line, sizeof(line), "%-14s%5.2f %5.2f %5.2f", stats.name.c_str(), stats.mean, stats.p50, stats.p99);
+        Hud::drawText(*pFrameBuffer, 0, y, line, sf::Color::White, scale);
+    }
 
-        // Draw sky.
-        // pWindow->drawVericalLine((int)HEIGHT, (int)halfHeight, rayCount, sf::Color(0, 199, 199, 255));
-        pWindow->drawTextureVerticalLine(rayCount, halfHeight, (float)gameHeight + 1, (int)((float)sky.getWidth() * (rayAngle / 360.f)) % (int)sky.getWidth(), sky);
+    y += Hud::getLineHeight(scale);
+    snprintf(line, sizeof(line), "resolution %zux%zu budget %3.0f%%", gameLength, gameHeight, pResolution->getBudgetUse() * 100.f);
+    Hud::drawText(*pFrameBuffer, 0, y, line, sf::Color::Yellow, scale);
 
-        // Draw untextured walls.
-        // pWindow->drawVericalLine((int)(halfHeight - wallHeight), (int)(halfHeight + wallHeight), rayCount, sf::Color(100, 62, 10, 100));
+    y += Hud::getLineHeight(scale);
+    InputLatency latency = getInputLatency();
+    snprintf(line, sizeof(line), "input latency p50 %.1f p99 %.1f ms", latency.p50, latency.p99);
+    Hud::drawText(*pFrameBuffer, 0, y, line, sf::Color::Yellow, scale);
+}
+#endif
 
-        // Draw textures.
-        pWindow->drawWallTextureVerticalLine(rayCount, wallHeight, textureVerticalSlipIdx, t);
+void Game::loadNewMaze() {
+    PROFILE_SCOPE("load new maze");
+    Level level = nextLevel.get(); // Only waits when the maze was solved faster than the next one was generated.
+    std::optional<Map> retired = std::move(map);
+    map = std::move(level.map);
+    sky = std::move(level.sky);
+    sprites = std::move(level.sprites);
+    prefetchNextLevel(std::move(retired));
+    if (autopilotEnabled) followPath(level.solution.empty() ? map.solve() : level.solution);
 
-        rayAngle += incrimentAngle;
-    }
+    player.setX(1.5f);
+    player.setY(1.5f);
+    previousPlayer = camera = player; // Do not interpolate across the jump.
+    minimap.reset();
+    updateHelperWindowScale();
 }
 
-void Game::renderHelperWindowPixel(int x, int y, const sf::Color &color) {
-    for (int i = 0; i < helperWindowScale; i++) {
-        for (int j = 0; j < helperWindowScale; j++) {
-            pWindow->setTruePixelColor(helperWindowScale * x + i, helperWindowScale * y + j, color);
-        }
-    }
+Map Game::generateMap(int size_x, int size_y, uint64_t seed) const {
+    if (streamingMinSize > 0 && std::max(size_x, size_y) >= streamingMinSize)
+        return Map(size_x, size_y, seed, MazeAlgorithm::Chunked);
+    return Map(size_x, size_y, seed);
 }
 
-void Game::renderHelperWindow() {
-    if (!helperVisibility) return;
-    const std::vector<std::vector<int>> &mapArray = map.getMap();
+SpriteLayer Game::placeSprites(const Map &map) {
+    SpriteLayer layer;
+    layer.add((float)map.getWidth() - 1.5f, (float)map.getHeight() - 1.5f, Marker);
+    if (map.isChunked()) return layer;
 
-    for (int i = 0; i < (int)mapArray.front().size(); i++) {
-        for (int j = 0; j < (int)mapArray.size(); j++) {
-            renderHelperWindowPixel(i, j, map.getTileColor(i, j));
+    for (int y = 1; y < map.getHeight() - 1; y++) {
+        for (int x = 1; x < map.getWidth() - 1; x++) {
+            if (map.isSolid(x, y) || (x == 1 && y == 1)) continue;
+            int walls = map.isSolid(x - 1, y) + map.isSolid(x + 1, y) + map.isSolid(x, y - 1) + map.isSolid(x, y + 1);
+            if (walls == 3) layer.add((float)x + 0.5f, (float)y + 0.5f, Pickup);
         }
     }
-
-    renderHelperWindowPixel((int)player.getX(), (int)player.getY(), sf::Color::Blue);
+    return layer;
 }
 
-void Game::loadNewMaze() {
-    // Includes padding, so the size increases
-    map = Map((int)map.getMap().front().size(), (int)map.getMap().size());
-    player.setX(1.5f);
-    player.setY(1.5f);
-    helperWindowScale = std::max((int)std::min(trueLength / 2 / map.getMap().front().size(), trueHeight / 2 / map.getMap().size()), 1); // scale to main window.
-    changeSkyTexture("../textures/skyTexture" + std::to_string(rand() % 2 + 1) + "P3.ppm");
+void Game::prefetchNextLevel(std::optional<Map> retired) {
+    // Includes padding, so the size increases. Random choices stay on this thread, rand() is not thread safe.
+    int size_x = map.getWidth(), size_y = map.getHeight();
+    uint64_t seed = (uint64_t)rand() << 32 | (uint64_t)rand();
+    std::string skyPath = "../textures/skyTexture" + std::to_string(rand() % 2 + 1) + "P6.ppm";
+    // Read now, the task may still be running while members declared after nextLevel are destroyed.
+    bool solve = autopilotEnabled;
+
+    nextLevel = std::async(std::launch::async, [this, size_x, size_y, seed, skyPath, solve, old = std::move(retired)]() mutable {
+        PROFILE_SCOPE("prefetch level");
+        old.reset(); // Large mazes take a while to free as well.
+        TextureCache::purgeUnused(); // Drops what only the retired level used, its sky included.
+        Map nextMap = generateMap(size_x, size_y, seed);
+        SpriteLayer nextSprites = placeSprites(nextMap);
+        std::vector<uint32_t> solution = solve ? nextMap.solve() : std::vector<uint32_t>();
+        return Level{std::move(nextMap), TextureCache::get(skyPath), std::move(nextSprites), std::move(solution)};
+    });
 }
 
 void Game::play() {
-    // Used for calculating deltaTime
-    std::chrono::_V2::system_clock::time_point endOfPrevLoop = std::chrono::high_resolution_clock::now();
-    std::chrono::_V2::system_clock::time_point spacePress = std::chrono::high_resolution_clock::now();
-    const std::vector<std::vector<int>> &mapArray = map.getMap();
-    int maze_x = (int)map.getMap().front().size() - 2, maze_y = (int)map.getMap().size() - 2;
+    // Frames are rendered on their own thread, so drawing frame N + 1 overlaps presenting frame N.
+    std::thread renderThread(&Game::renderLoop, this);
 
-    // Game loop.
     while (pWindow->isOpen()) {
-        renderFrameToBuffer();
+        const FrameBuffer *pFrame = pFrames->acquire();
+        if (!pFrame) break;
 
-        renderHelperWindow();
+        {
+            PROFILE_SCOPE("display");
+            pWindow->display(*pFrame); // Display buffer.
+        }
+
+        // The frame is considered seen once it has been handed to the driver.
+        std::chrono::steady_clock::time_point inputTime = pFrames->getInputTime();
+        if (inputTime != std::chrono::steady_clock::time_point{})
+            addInputLatency(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - inputTime).count());
+        presentedFrames.fetch_add(1);
+        presentedFrames.notify_one();
+    }
 
-        pWindow->display(); // Display buffer.
+    pFrames->close();
+    presentedFrames = std::numeric_limits<unsigned long>::max();
+    presentedFrames.notify_one();
+    renderThread.join();
 
-        // Provide time delta between frames
-        player.movement((float)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - endOfPrevLoop).count(), mapArray);
+    InputLatency latency = getInputLatency();
+    if (latency.samples > 0)
+        std::cout << "Input latency ms: mean " << latency.mean << ", p50 " << latency.p50 << ", p99 " << latency.p99
+                  << " over " << latency.samples << " presses" << std::endl;
+}
+
+void Game::renderLoop() {
+    std::chrono::steady_clock::time_point lastFrameStart = std::chrono::steady_clock::now();
+    std::chrono::_V2::system_clock::time_point spacePress = std::chrono::high_resolution_clock::now();
+#ifdef PROFILING
+    std::chrono::_V2::system_clock::time_point hudPress = spacePress, tracePress = spacePress;
+#endif
+    int maze_x = map.getWidth() - 2, maze_y = map.getHeight() - 2;
+    double simulationLag = 0; // Milliseconds of real time not simulated yet.
+    PlayerInput lastInput;
+    std::chrono::steady_clock::time_point pressTime{}, appliedPressTime{}; // Of a press not yet simulated, and not yet drawn.
+    unsigned long publishedFrames = 0;
+    previousPlayer = camera = player;
+
+    // Game loop.
+    while (true) {
+#ifdef PROFILING
+        Profiler::endFrame();
+#endif
+        PROFILE_SCOPE("frame");
+
+        // Without render ahead the input is read as late as possible, once the previous frame is on screen.
+        if (renderAhead == 0) {
+            PROFILE_SCOPE("present wait");
+            unsigned long presented;
+            while ((presented = presentedFrames.load()) < publishedFrames)
+                presentedFrames.wait(presented);
+        }
+        std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+        {
+            PROFILE_SCOPE("simulation");
+            PlayerInput input = Player::readInput();
+            if ((input.keys & ~lastInput.keys) != 0 && pressTime == std::chrono::steady_clock::time_point{}) pressTime = frameStart;
+            lastInput = input;
+
+            // Movement advances in fixed ticks whatever the frame rate, frames show a blend of the last two.
+            simulationLag = std::min(simulationLag + std::chrono::duration<double, std::milli>(frameStart - lastFrameStart).count(), maxSimulationLagMs);
+            lastFrameStart = frameStart;
+            while (simulationLag >= simulationTickMs) {
+                previousPlayer = player;
+                player.movement(autopilotEnabled ? autopilot.steer(player) : input, simulationTickMs, map);
+                simulationLag -= simulationTickMs;
+                if (appliedPressTime == std::chrono::steady_clock::time_point{}) appliedPressTime = pressTime;
+                pressTime = {};
+            }
+            camera = Player::interpolate(previousPlayer, player, (float)(simulationLag / simulationTickMs));
+        }
 
         if (player.getX() >= (float)maze_x && player.getY() >= (float)maze_y + 0.7f) {
-            std::cout << "Solved: " << maze_x << " * " << maze_y << std::endl;
+            rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            std::cout << "Solved: " << maze_x << " * " << maze_y << " in " << levelFrames << " frames, frame ms mean "
+                      << levelFrameMsTotal / (float)std::max(levelFrames, (size_t)1) << " max " << levelFrameMsMax
+                      << ", peak memory " << usage.ru_maxrss / 1024 << " MB" << std::endl;
+            levelFrames = 0;
+            levelFrameMsTotal = levelFrameMsMax = 0;
             loadNewMaze();
             maze_x += 2;
             maze_y += 2;
         }
 
+        // A breadcrumb marks every cell the first time it is entered.
+        if (minimap.visit(map, (int)camera.getX(), (int)camera.getY()))
+            sprites.add(floorf(camera.getX()) + 0.5f, floorf(camera.getY()) + 0.5f, Breadcrumb);
+
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space) && std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - spacePress).count() > 300) {
             helperVisibility = !helperVisibility;
             spacePress = std::chrono::high_resolution_clock::now();
         }
 
-        endOfPrevLoop = std::chrono::high_resolution_clock::now();
+#ifdef PROFILING
+        // F1 toggles the stage timing HUD, F2 saves a trace of the buffered frames.
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::F1) && std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - hudPress).count() > 300) {
+            hudVisibility = !hudVisibility;
+            hudPress = std::chrono::high_resolution_clock::now();
+        }
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::F2) && std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - tracePress).count() > 300) {
+            if (Profiler::writeChromeTrace("trace.json")) std::cout << "Saved trace.json" << std::endl;
+            tracePress = std::chrono::high_resolution_clock::now();
+        }
+#endif
+
+        pFrameBuffer = &pFrames->getBackBuffer();
+        pFrameBuffer->resize(gameLength, gameHeight);
+
+        renderFrameToBuffer();
+
+        renderHelperWindow();
+
+#ifdef PROFILING
+        renderProfilerHud();
+#endif
+
+        pFrames->setInputTime(appliedPressTime);
+        appliedPressTime = {};
+        std::chrono::steady_clock::time_point publishStart = std::chrono::steady_clock::now();
+        {
+            PROFILE_SCOPE("present wait");
+            if (!pFrames->publish()) break;
+        }
+        publishedFrames++;
+
+        // Waiting for the previous frame to be presented is left out, the budget is for the frame's own work.
+        float frameMs = std::chrono::duration<float, std::milli>(publishStart - frameStart).count();
+        levelFrames++;
+        levelFrameMsTotal += frameMs;
+        levelFrameMsMax = std::max(levelFrameMsMax, frameMs);
+        if (pResolution->addFrameTime(frameMs))
+            applyResolution();
     }
 }
 
 Game::~Game() {
+    delete pResolution;
+    delete pFrames;
+    delete pRenderer;
     delete pWindow;
 }
-
-float Game::degreesToRadians(float degrees) {
-    return degrees * (float)M_PI / 180.f;
-}
\ No newline at end of file
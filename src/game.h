@@ -1,40 +1,135 @@
 #ifndef gameH
 #define gameH
 
+#include <atomic>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+
 #include "window.h"
+#include "autopilot.h"
+#include "framepipeline.h"
 #include "player.h"
 #include "map.h"
+#include "minimap.h"
+#include "renderer.h"
+#include "resolutioncontroller.h"
+#include "spritelayer.h"
+
+// Milliseconds from reading a key press to presenting the first frame that shows it, over the last presses.
+struct InputLatency {
+    float mean, p50, p99;
+    size_t samples;
+};
 
 // Class representing game logic.
 class Game {
+    // A maze ready to be played, with the assets it needs loaded.
+    struct Level {
+        Map map;
+        std::shared_ptr<const Texture> sky;
+        SpriteLayer sprites;
+        std::vector<uint32_t> solution; // Of map, only solved while the autopilot is on.
+    };
+
+    static constexpr float simulationTickMs = 1000.f / 120.f;
+    static constexpr double maxSimulationLagMs = 250; // Longer stalls are dropped instead of caught up on.
+    static constexpr size_t latencySamples = 64;
+
     Window *pWindow;
+    FramePipeline *pFrames;
+    FrameBuffer *pFrameBuffer; // Back buffer of pFrames the current frame is drawn into.
+    Renderer *pRenderer;
+    ResolutionController *pResolution;
     Player player;
-    size_t gameLength, gameHeight, trueLength, trueHeight;
-    int fov = 60, helperWindowScale;
-    unsigned int rayCastingPrecision = 64;
+    Player previousPlayer; // Before the last simulation tick.
+    Player camera;         // Between previousPlayer and player, what the frame being drawn shows.
+    size_t gameLength, gameHeight;
+    int helperWindowScale;
+    int streamingMinSize; // Mazes at least this wide or long are generated in chunks while exploring, 0 disables it.
     Map map;
-    Texture sky;
+    std::shared_ptr<const Texture> sky;
+    SpriteLayer sprites; // Pickups and markers of the maze, and breadcrumbs dropped in every cell visited.
+    Minimap minimap;
+    std::future<Level> nextLevel; // Generated in the background while the current one is played.
+    std::atomic<bool> autopilotEnabled{false};
+    Autopilot autopilot;
+    size_t levelFrames = 0;                         // Frames rendered in the current maze.
+    float levelFrameMsTotal = 0, levelFrameMsMax = 0; // Their frame times, without waiting to present.
     bool helperVisibility = false;
+    int renderAhead = 1;
+    std::atomic<unsigned long> presentedFrames{0};
+    mutable std::mutex latencyMutex;
+    std::deque<float> inputLatencies;
+#ifdef PROFILING
+    bool hudVisibility = false;
+#endif
 
 public:
-    Game(size_t length, size_t height, int scale, int maze_x_starting_size, int maze_y_starting_size);
+    // renderThreads set to 0 uses all hardware threads, smoothUpscale filters the upscaled frame bilinearly.
+    // targetFrameMs above 0 adapts the render resolution, between a quarter of the window's and the window's, to that frame time.
+    Game(size_t length, size_t height, int scale, int maze_x_starting_size, int maze_y_starting_size, unsigned int renderThreads = 0,
+         int streamingMinSize = 0, bool smoothUpscale = false, float targetFrameMs = 0);
 
     void changeSkyTexture(std::string filePath);
 
-    void renderFrameToBuffer();
+    void setRayCastingMode(RayCastingMode mode);
+
+    // Frames rendered while the previous one waits to be presented. 0 reads input for a frame only once
+    // the previous one is on screen, which lowers latency at the cost of frame rate. At most 1.
+    void setRenderAhead(int frames);
 
-    void renderHelperWindowPixel(int x, int y, const sf::Color &color);
+    InputLatency getInputLatency() const;
+
+    // Let the autopilot walk every maze to its exit, for unattended soak and benchmark runs.
+    // Each solved maze prints its frame times and the peak memory use.
+    void setAutopilot(bool enabled);
+
+    void renderFrameToBuffer();
 
     void renderHelperWindow();
 
+#ifdef PROFILING
+    // Draw rolling stage timings from Profiler in the top left corner.
+    void renderProfilerHud();
+#endif
+
     void loadNewMaze();
 
+    // Current render resolution and how much of the frame time budget it uses.
+    const ResolutionController &getResolution() const;
+
+private:
+    // Render at the resolution picked by the controller.
+    void applyResolution();
+
+    // Size minimap cells to fit the current resolution.
+    void updateHelperWindowScale();
+
+    // Runs on its own thread during play: simulates fixed ticks and renders frames into pFrames until it is closed.
+    void renderLoop();
+
+    void addInputLatency(float latencyMs);
+
+    // New maze of size_x * size_y cells (both odd), chunked when it reaches streamingMinSize.
+    Map generateMap(int size_x, int size_y, uint64_t seed) const;
+
+    // Follow path through the current maze to where it counts as solved.
+    void followPath(const std::vector<uint32_t> &path);
+
+    // Pickups in the dead ends of a flat maze and a marker in front of the exit of any maze.
+    // Chunked mazes are not searched for dead ends, that would generate every chunk.
+    static SpriteLayer placeSprites(const Map &map);
+
+    // Start generating the level after the current one on a background thread, which also frees retired.
+    void prefetchNextLevel(std::optional<Map> retired = std::nullopt);
+
+public:
+
     void play();
 
     ~Game();
-
-private:
-    float degreesToRadians(float degrees);
 };
 
 #endif
\ No newline at end of file
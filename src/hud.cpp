@@ -0,0 +1,53 @@
+#include "hud.h"
+
+#include <cctype>
+
+void Hud::drawText(FrameBuffer &frameBuffer, int x, int y, const std::string &text, const sf::Color &color, int scale) {
+    Pixel foreground = toPixel(color), background = toPixel(sf::Color::Black);
+    int top = (int)frameBuffer.getHeight() - 1 - y; // FrameBuffer y grows upwards.
+
+    for (char character : text) {
+        unsigned int glyph = getGlyph(character);
+        // Each glyph cell has one pixel of spacing to the right and below.
+        for (int row = 0; row <= glyphHeight; row++) {
+            for (int column = 0; column <= glyphWidth; column++) {
+                bool set = row < glyphHeight && column < glyphWidth && (glyph >> ((glyphHeight - 1 - row) * glyphWidth + (glyphWidth - 1 - column)) & 1);
+                for (int i = 0; i < scale; i++) {
+                    for (int j = 0; j < scale; j++) {
+                        frameBuffer.setGamePixel(x + column * scale + i, top - row * scale - j, set ? foreground : background);
+                    }
+                }
+            }
+        }
+        x += (glyphWidth + 1) * scale;
+    }
+}
+
+int Hud::getLineHeight(int scale) {
+    return (glyphHeight + 1) * scale;
+}
+
+unsigned int Hud::getGlyph(char character) {
+    static const unsigned int digits[] = {
+        075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757, 075717};
+    static const unsigned int letters[] = {
+        025755, 065656, 034443, 065556, 074647, 074644, 034553, 055755, 072227, 011152, 055655, 044447, 057755,
+        065555, 025552, 065644, 025563, 065655, 034216, 072222, 055557, 055552, 055775, 055255, 055222, 071247};
+
+    character = (char)toupper((unsigned char)character);
+    if (isdigit((unsigned char)character)) return digits[character - '0'];
+    if (isupper((unsigned char)character)) return letters[character - 'A'];
+
+    switch (character) {
+    case '.':
+        return 000002;
+    case ':':
+        return 002020;
+    case '-':
+        return 000700;
+    case '/':
+        return 011244;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef hudH
+#define hudH
+
+#include <string>
+
+#include "framebuffer.h"
+
+// Text overlay drawn straight into a FrameBuffer with a built in 3x5 pixel font.
+class Hud {
+    static const int glyphWidth = 3, glyphHeight = 5;
+
+public:
+    // Draw text on a black background with its top left corner at (x, y), y counted from the top of the screen.
+    // Lowercase letters are drawn as uppercase, unknown characters as spaces.
+    static void drawText(FrameBuffer &frameBuffer, int x, int y, const std::string &text, const sf::Color &color, int scale = 1);
+
+    // Height of one line of text including spacing.
+    static int getLineHeight(int scale = 1);
+
+private:
+    // Rows of the glyph from the top, 3 bits each with the leftmost pixel as the highest bit.
+    static unsigned int getGlyph(char character);
+};
+
+#endif
@@ -11,15 +11,19 @@
 int main() {
     srand((unsigned int)time(NULL));
     std::ifstream options;
-    size_t LENGTH = 1280, HEIGHT = 720, SCALE = 3, MAZE_WIDTH = 11, MAZE_HEIGHT = 11;
-    std::string temp;
+    size_t LENGTH = 1280, HEIGHT = 720, SCALE = 3, MAZE_WIDTH = 11, MAZE_HEIGHT = 11, RENDER_THREADS = 0, STREAMING_MIN_SIZE = 0, RENDER_AHEAD = 1, AUTOPILOT = 0;
+    float TARGET_FRAME_MS = 0;
+    std::string temp, RAY_CASTING = "dda", UPSCALE_FILTER = "nearest";
 
     options.open("../settings.txt");
-    options >> temp >> LENGTH >> temp >> HEIGHT >> temp >> SCALE >> temp >> MAZE_WIDTH >> temp >> MAZE_HEIGHT;
+    options >> temp >> LENGTH >> temp >> HEIGHT >> temp >> SCALE >> temp >> MAZE_WIDTH >> temp >> MAZE_HEIGHT >> temp >> RAY_CASTING >> temp >> RENDER_THREADS >> temp >> STREAMING_MIN_SIZE >> temp >> UPSCALE_FILTER >> temp >> TARGET_FRAME_MS >> temp >> RENDER_AHEAD >> temp >> AUTOPILOT;
 
     options.close();
 
-    Game game(LENGTH, HEIGHT, (int)SCALE, (int)MAZE_WIDTH, (int)MAZE_HEIGHT);
+    Game game(LENGTH, HEIGHT, (int)SCALE, (int)MAZE_WIDTH, (int)MAZE_HEIGHT, (unsigned int)RENDER_THREADS, (int)STREAMING_MIN_SIZE, UPSCALE_FILTER == "bilinear", TARGET_FRAME_MS);
+    game.setRayCastingMode(RAY_CASTING == "marching" ? RayCastingMode::Marching : RayCastingMode::DDA);
+    game.setRenderAhead((int)RENDER_AHEAD);
+    game.setAutopilot(AUTOPILOT != 0);
     game.play();
 
     return 0;
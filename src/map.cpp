@@ -1,21 +1,63 @@
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 #include "map.h"
+#include "texturecache.h"
+
+const std::array<sf::Color, tileTypeCount> Map::tileColors = {sf::Color::White, sf::Color::Black, sf::Color::Green, sf::Color::Yellow};
 
 void Map::setWallTexture(std::string filePath) {
-    wallTexture = Texture(filePath);
+    setTileTextures(Wall, {filePath});
 }
 
 void Map::setEntranceTexture(std::string filePath) {
-    entranceTexture = Texture(filePath);
+    setTileTextures(Entrance, {filePath});
 }
 
 void Map::setExitTexture(std::string filePath) {
-    exitTexture = Texture(filePath);
+    setTileTextures(Exit, {filePath});
+}
+
+void Map::setTileTextures(uint8_t tile, const std::vector<std::string> &filePaths) {
+    loadTileTextures(tile, filePaths);
+    packAtlas();
+}
+
+void Map::loadTileTextures(uint8_t tile, const std::vector<std::string> &filePaths) {
+    tileTextures[tile].clear();
+    for (const std::string &filePath : filePaths) {
+        tileTextures[tile].push_back(TextureCache::get(filePath));
+    }
+}
+
+void Map::setFloorTexture(std::string filePath) {
+    floorTexture = TextureCache::get(filePath);
+    packAtlas();
+}
+
+void Map::setCeilingTexture(std::string filePath) {
+    ceilingTexture = TextureCache::get(filePath);
+    packAtlas();
+}
+
+void Map::packAtlas() {
+    atlas.clear();
+    Texture black;
+    for (size_t tile = 0; tile < tileTypeCount; tile++) {
+        firstRegion[tile] = (uint32_t)atlas.getRegionCount();
+        regionCount[tile] = (uint32_t)std::max(tileTextures[tile].size(), (size_t)1);
+        if (tileTextures[tile].empty()) atlas.add(black);
+        for (const std::shared_ptr<const Texture> &texture : tileTextures[tile]) {
+            atlas.add(*texture);
+        }
+    }
+    floorRegion = floorTexture ? std::optional(atlas.add(*floorTexture)) : std::nullopt;
+    ceilingRegion = ceilingTexture ? std::optional(atlas.add(*ceilingTexture)) : std::nullopt;
 }
 
 Map::Map() {
-    map = {
+    const std::vector<std::vector<uint8_t>> layout = {
         {1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
         {1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
         {1, 0, 0, 0, 0, 0, 0, 0, 0, 1},
@@ -28,50 +70,117 @@ Map::Map() {
         {1, 1, 1, 1, 1, 1, 1, 1, 2, 1},
     };
 
-    setWallTexture("../textures/myTexture3.ppm");
-    setEntranceTexture("../textures/entranceTextureP3.ppm");
-    setExitTexture("../textures/exitTextureP3.ppm");
-}
+    reset((int)layout.front().size(), (int)layout.size(), Empty);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            setTile(x, y, layout[(size_t)y][(size_t)x]);
+        }
+    }
 
-Texture &Map::getTexture(int x, int y) {
-    switch (map[y][x]) {
-    case 1:
-        return wallTexture;
+    loadTileTextures(Wall, {"../textures/myTexture3.ppm"});
+    loadTileTextures(Entrance, {"../textures/entranceTextureP6.ppm"});
+    loadTileTextures(Exit, {"../textures/exitTextureP6.ppm"});
+    floorTexture = TextureCache::get("../textures/floorTexture.ppm");
+    packAtlas();
+}
 
-    case 2:
-        return exitTexture;
+void Map::setTile(int x, int y, uint8_t tile) {
+    if (pChunks) throw std::logic_error("tiles of a chunked map cannot be changed");
+    size_t idx = (size_t)y * (size_t)width + (size_t)x;
+    tiles[idx] = tile;
+    if (tile == Empty)
+        solid[idx >> 6] &= ~(1ull << (idx & 63));
+    else
+        solid[idx >> 6] |= 1ull << (idx & 63);
 
-    case 3:
-        return entranceTexture;
+    // Only words within reach of the cell change, so only the blocks around it are built again.
+    wallDistances.invalidate(x, y);
+}
 
-    default:
-        return deafultTexture;
-    }
+sf::Color Map::getTileColor(int x, int y) const {
+    return tileColors[getTile(x, y)];
 }
 
-sf::Color Map::getTileColor(int x, int y) {
-    switch (map[y][x]) {
-    case 1:
-        return sf::Color::Black;
+// Frontiers are expanded a whole level at a time, so the search needs no queue of every cell. Flat mazes start with
+// their walls marked visited, so a neighbour costs one bit test. Chunked mazes mark a cell visited when it is first
+// looked at, walls included, so each cell is tested against the map once.
+std::vector<uint32_t> Map::findPath(int fromX, int fromY, int toX, int toY) const {
+    size_t cellCount = (size_t)width * (size_t)height;
+    if (cellCount > UINT32_MAX) throw std::length_error("map too big to search");
+    auto inside = [&](int x, int y) { return x >= 0 && x < width && y >= 0 && y < height; };
+    if (!inside(fromX, fromY) || !inside(toX, toY) || isSolid(fromX, fromY) || isSolid(toX, toY)) return {};
+
+    // Steps +x, -x, +y and -y, numbered as stored in cameFrom.
+    const std::array<int, 4> stepX = {1, -1, 0, 0}, stepY = {0, 0, 1, -1};
+    const std::array<int64_t, 4> stepIdx = {1, -1, width, -(int64_t)width};
 
-    case 2:
-        return sf::Color::Green;
+    const uint64_t *pSolid = getSolidBits();
+    std::vector<uint64_t> visited = pSolid ? std::vector<uint64_t>(pSolid, pSolid + solid.size()) : std::vector<uint64_t>((cellCount + 63) / 64);
+    std::vector<uint8_t> cameFrom((cellCount + 3) / 4); // Step taken into each cell, two bits each.
+    uint32_t start = (uint32_t)((size_t)fromY * (size_t)width + (size_t)fromX), goal = (uint32_t)((size_t)toY * (size_t)width + (size_t)toX);
+    visited[start >> 6] |= 1ull << (start & 63);
 
-    case 3:
-        return sf::Color::Yellow;
+    std::vector<uint32_t> frontier = {start}, next;
+    bool found = start == goal;
+    while (!found && !frontier.empty()) {
+        next.clear();
+        for (uint32_t cell : frontier) {
+            int x = (int)(cell % (uint32_t)width), y = (int)(cell / (uint32_t)width);
+            for (uint8_t step = 0; step < 4; step++) {
+                int nextX = x + stepX[step], nextY = y + stepY[step];
+                if (!inside(nextX, nextY)) continue;
+                uint32_t neighbour = (uint32_t)((int64_t)cell + stepIdx[step]);
+                uint64_t bit = 1ull << (neighbour & 63);
+                if (visited[neighbour >> 6] & bit) continue;
+                visited[neighbour >> 6] |= bit;
+                if (!pSolid && isSolid(nextX, nextY)) continue;
+
+                cameFrom[neighbour >> 2] |= (uint8_t)(step << (neighbour & 3) * 2);
+                next.push_back(neighbour);
+                found |= neighbour == goal;
+            }
+        }
+        frontier.swap(next);
+    }
+    if (!found) return {};
+
+    std::vector<uint32_t> path = {goal};
+    for (uint32_t cell = goal; cell != start; path.push_back(cell)) {
+        uint8_t step = cameFrom[cell >> 2] >> (cell & 3) * 2 & 3;
+        cell = (uint32_t)((int64_t)cell - stepIdx[step]);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
 
-    default:
-        return sf::Color::White;
+void Map::updateSolid() {
+    size_t cells = tiles.size();
+    for (size_t word = 0; word < solid.size(); word++) {
+        uint64_t bits = 0;
+        size_t first = word * 64, count = std::min((size_t)64, cells - first);
+        for (size_t i = 0; i < count; i++) {
+            bits |= (uint64_t)(tiles[first + i] != Empty) << i;
+        }
+        solid[word] = bits;
     }
 }
 
+void Map::reset(int newWidth, int newHeight, uint8_t tile) {
+    width = newWidth;
+    height = newHeight;
+    size_t cells = (size_t)width * (size_t)height;
+    tiles.assign(cells, tile);
+    solid.assign((cells + 63) / 64, tile == Empty ? 0 : ~0ull);
+    wallDistances.reset(width, height);
+}
+
 // Random int in range (inclusive)
 int Map::randInRange(int start, int end) {
     return rand() % (end - start + 1) + start;
 }
 
-// Regenerate map into a maze
-void Map::generateMaze(int x1, int y1, int x2, int y2) {
+// Original recursive generator, kept to compare against. Uses rand(), so it is seeded by srand().
+void Map::generateMazeRecursive(int x1, int y1, int x2, int y2) {
     int xRange = x2 - x1, yRange = y2 - y1;
     if (xRange <= 0 || yRange <= 0) return; // Recursion exit point
 
@@ -84,7 +193,7 @@ void Map::generateMaze(int x1, int y1, int x2, int y2) {
 
         // Fill the wall
         for (int i = x1; i <= x2; i++) {
-            map[wallPosition][i] = 1;
+            setTile(i, wallPosition, Wall);
         }
 
         int holePosition;
@@ -92,10 +201,10 @@ void Map::generateMaze(int x1, int y1, int x2, int y2) {
             holePosition = randInRange(x1, x2);
         } while (holePosition % 2 == 0);
 
-        map[wallPosition][holePosition] = 0;
+        setTile(holePosition, wallPosition, Empty);
 
-        generateMaze(x1, y1, x2, wallPosition - 1);
-        generateMaze(x1, wallPosition + 1, x2, y2);
+        generateMazeRecursive(x1, y1, x2, wallPosition - 1);
+        generateMazeRecursive(x1, wallPosition + 1, x2, y2);
     } else {
         // Find and odd x coord to put wall
         int wallPosition;
@@ -105,7 +214,7 @@ void Map::generateMaze(int x1, int y1, int x2, int y2) {
 
         // Fill the wall
         for (int i = y1; i <= y2; i++) {
-            map[i][wallPosition] = 1;
+            setTile(wallPosition, i, Wall);
         }
 
         int holePosition;
@@ -113,42 +222,59 @@ void Map::generateMaze(int x1, int y1, int x2, int y2) {
             holePosition = randInRange(y1, y2);
         } while (holePosition % 2 == 0);
 
-        map[holePosition][wallPosition] = 0;
+        setTile(wallPosition, holePosition, Empty);
 
-        generateMaze(x1, y1, wallPosition - 1, y2);
-        generateMaze(wallPosition + 1, y1, x2, y2);
+        generateMazeRecursive(x1, y1, wallPosition - 1, y2);
+        generateMazeRecursive(wallPosition + 1, y1, x2, y2);
     }
 }
 
 // size_x and size_y MUST be odd
-Map::Map(int size_x, int size_y) {
+Map::Map(int size_x, int size_y) : Map(size_x, size_y, (uint64_t)rand()) {}
+
+// size_x and size_y MUST be odd
+Map::Map(int size_x, int size_y, uint64_t seed, MazeAlgorithm algorithm, ThreadPool *pGenerationPool) {
     if (size_x % 2 == 0 || size_y % 2 == 0)
         throw std::invalid_argument("size_x and size_y must be odd");
 
-    map.clear();
-    map.push_back(std::vector<int>((size_t)size_x + 2, 1));
-    for (int i = 1; i < size_y + 1; i++) {
-        map.push_back(std::vector<int>((size_t)size_x + 2, 0));
-        map.back().front() = map.back().back() = 1;
+    // Wall cells mix all three wall textures.
+    loadTileTextures(Wall, {"../textures/myTexture1.ppm", "../textures/myTexture2.ppm", "../textures/myTexture3.ppm"});
+    loadTileTextures(Entrance, {"../textures/entranceTextureP6.ppm"});
+    loadTileTextures(Exit, {"../textures/exitTextureP6.ppm"});
+    floorTexture = TextureCache::get("../textures/floorTexture.ppm");
+    packAtlas();
+
+    if (algorithm == MazeAlgorithm::Chunked) {
+        width = size_x + 2;
+        height = size_y + 2;
+        pChunks = std::make_unique<ChunkCache>(width, height, seed, residentChunks);
+        return;
     }
-    map.push_back(std::vector<int>((size_t)size_x + 2, 1));
 
-    generateMaze(1, 1, size_x, size_y);
-    map[size_y + 1][size_x] = 2; // Set exit.
-    map[0][1] = 3;               // Set entrance;
+    // Empty inside surrounded by walls.
+    reset(size_x + 2, size_y + 2, Empty);
+    for (int x = 0; x < width; x++) {
+        setTile(x, 0, Wall);
+        setTile(x, height - 1, Wall);
+    }
+    for (int y = 0; y < height; y++) {
+        setTile(0, y, Wall);
+        setTile(width - 1, y, Wall);
+    }
 
-    // setWallTexture("../textures/starry_night.ppm");
-    setWallTexture("../textures/myTexture" + std::to_string(rand() % 3 + 1) + ".ppm");
-    setEntranceTexture("../textures/entranceTextureP3.ppm");
-    setExitTexture("../textures/exitTextureP3.ppm");
+    if (algorithm == MazeAlgorithm::Recursive)
+        generateMazeRecursive(1, 1, size_x, size_y);
+    else
+        MazeGenerator::generate(tiles.data(), (size_t)width, {1, 1, size_x, size_y}, seed, pGenerationPool);
+    updateSolid();
+    setTile(size_x, size_y + 1, Exit); // Set exit.
+    setTile(1, 0, Entrance);           // Set entrance;
 }
 
-const std::vector<std::vector<int>> &Map::getMap() { return map; }
-
 void Map::print() {
-    for (std::vector<int> line : map) {
-        for (int val : line) {
-            std::cout << val;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            std::cout << (int)getTile(x, y);
         }
         std::cout << std::endl;
     }
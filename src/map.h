@@ -1,14 +1,42 @@
 #ifndef mapH
 #define mapH
 
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <vector>
 
+#include "chunkcache.h"
+#include "mazegenerator.h"
 #include "texture.h"
+#include "textureatlas.h"
+#include "walldistances.h"
+
+// Maze generation algorithm.
+enum class MazeAlgorithm {
+    Iterative, // Recursive division with an explicit stack and a seeded generator.
+    Recursive, // Original recursive division using rand() with rejection loops.
+    Chunked    // Generated chunk by chunk when first visited, for mazes too big to keep in memory.
+};
 
 // Class representing a game map geometry, textures and marked places
 class Map {
-    std::vector<std::vector<int>> map;
-    Texture wallTexture, deafultTexture, entranceTexture, exitTexture;
+    int width = 0, height = 0;
+    std::vector<uint8_t> tiles;  // One tile id per cell, row after row.
+    std::vector<uint64_t> solid; // One bit per cell in the same order, set for every non empty tile.
+    WallDistanceBlocks wallDistances;    // Of the tiles, built as rays reach them.
+    std::unique_ptr<ChunkCache> pChunks; // Replaces tiles and solid for chunked mazes.
+
+    static constexpr size_t residentChunks = 256; // About 3.3 MB of chunks.
+
+    // Texture variants of each tile id. Textures are shared with TextureCache, so a new maze does not reload them.
+    std::array<std::vector<std::shared_ptr<const Texture>>, tileTypeCount> tileTextures;
+    TextureAtlas atlas;                                        // All of tileTextures packed together.
+    std::array<uint32_t, tileTypeCount> firstRegion, regionCount; // Atlas regions of each tile id's variants.
+    std::shared_ptr<const Texture> floorTexture, ceilingTexture;  // Under and over every cell, none shows flat floor and sky.
+    std::optional<uint32_t> floorRegion, ceilingRegion;           // Their atlas regions.
+    static const std::array<sf::Color, tileTypeCount> tileColors;
 
 public:
     void setWallTexture(std::string filePath);
@@ -17,25 +45,101 @@ public:
 
     void setExitTexture(std::string filePath);
 
+    // Variants of the texture of tile, each cell of that tile shows one of them picked by its position.
+    void setTileTextures(uint8_t tile, const std::vector<std::string> &filePaths);
+
+    // Texture of the floor, or of a ceiling replacing the sky, repeated once per cell.
+    void setFloorTexture(std::string filePath);
+
+    void setCeilingTexture(std::string filePath);
+
     Map();
 
-    Texture &getTexture(int x, int y);
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    uint8_t getTile(int x, int y) const {
+        if (pChunks) return pChunks->getTile(x, y);
+        return tiles[(size_t)y * (size_t)width + (size_t)x];
+    }
+
+    // Whether the cell blocks rays and movement.
+    bool isSolid(int x, int y) const {
+        if (pChunks) return pChunks->isSolid(x, y);
+        size_t idx = (size_t)y * (size_t)width + (size_t)x;
+        return solid[idx >> 6] >> (idx & 63) & 1;
+    }
+
+    // Throws std::logic_error for chunked mazes, their tiles are regenerated whenever a chunk is reloaded.
+    void setTile(int x, int y, uint8_t tile);
+
+    bool isChunked() const { return pChunks != nullptr; }
+
+    // Occupancy bits of a flat maze, indexed like isSolid. nullptr for chunked mazes.
+    const uint64_t *getSolidBits() const { return pChunks ? nullptr : solid.data(); }
 
-    sf::Color getTileColor(int x, int y);
+    // WallDistances word of the cell at (x, y), rays use it to cross the empty space around the cell in one jump.
+    // Chunked mazes count the edges of their chunks as walls, so jumps stop there.
+    uint16_t getWallDistances(int x, int y) const {
+        if (pChunks) return pChunks->getWallDistances(x, y);
+        return wallDistances.get(tiles.data(), x, y);
+    }
+
+    // Chunk cache of a chunked maze, nullptr otherwise.
+    const ChunkCache *getChunks() const { return pChunks.get(); }
+
+    const TextureAtlas &getAtlas() const { return atlas; }
+
+    // Atlas region of the texture shown by the cell at (x, y), the same for a cell every time.
+    uint32_t getTextureRegion(int x, int y) const {
+        uint8_t tile = getTile(x, y);
+        uint32_t hash = (uint32_t)x * 0x9e3779b1u ^ (uint32_t)y * 0x85ebca77u;
+        return firstRegion[tile] + (hash >> 16) % regionCount[tile];
+    }
+
+    // Atlas regions of the floor and ceiling textures, empty when there is none.
+    std::optional<uint32_t> getFloorRegion() const { return floorRegion; }
+    std::optional<uint32_t> getCeilingRegion() const { return ceilingRegion; }
+
+    sf::Color getTileColor(int x, int y) const;
+
+    // Shortest path of empty cells from (fromX, fromY) to (toX, toY), as cell indices y * width + x from the first to the last.
+    // Empty when either cell is solid or they are not connected. Breadth first search keeps one visited bit and two bits of
+    // direction per cell plus the current and next frontier, under 40 MB for a 10001 x 10001 maze. Chunked mazes are searched
+    // through their chunk cache. Throws std::length_error for maps of more than 2^32 cells.
+    std::vector<uint32_t> findPath(int fromX, int fromY, int toX, int toY) const;
+
+    // Shortest path from the cell behind the entrance to the cell in front of the exit.
+    std::vector<uint32_t> solve() const { return findPath(1, 1, width - 2, height - 2); }
 
 private:
+    // Replace the textures of tile without repacking, so constructors pack their textures once.
+    void loadTileTextures(uint8_t tile, const std::vector<std::string> &filePaths);
+
+    // Pack tileTextures, then the floor and ceiling textures into atlas. Tiles without textures get a black one.
+    void packAtlas();
+
+    // Rebuild the occupancy bits after tiles were written directly.
+    void updateSolid();
+
+    // Size the map to width x height cells, all of them tile.
+    void reset(int newWidth, int newHeight, uint8_t tile);
+
     // Random int in range (inclusive)
     int randInRange(int start, int end);
 
     // Regenerate map into a maze
-    void generateMaze(int x1, int y1, int x2, int y2);
+    void generateMazeRecursive(int x1, int y1, int x2, int y2);
 
 public:
-    // size_x and size_y MUST be odd
+    // size_x and size_y MUST be odd, the maze is seeded from rand().
     Map(int size_x, int size_y);
 
-    const std::vector<std::vector<int>> &getMap();
+    // size_x and size_y MUST be odd, the same seed always generates the same maze.
+    // pGenerationPool optionally divides the maze on several threads, the result does not depend on it.
+    // Chunked mazes generate nothing up front and ignore pGenerationPool.
+    Map(int size_x, int size_y, uint64_t seed, MazeAlgorithm algorithm = MazeAlgorithm::Iterative, ThreadPool *pGenerationPool = nullptr);
 
     void print();
 };
-#endif
\ No newline at end of file
+#endif
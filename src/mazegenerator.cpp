@@ -0,0 +1,72 @@
+#include "mazegenerator.h"
+
+#include <algorithm>
+
+// The first divisions run breadth first until there are enough regions to share between threads.
+// Each of those gets a generator seeded from its index, so the maze depends only on the seed.
+void MazeGenerator::generate(uint8_t *tiles, size_t stride, const Region &maze, uint64_t seed, ThreadPool *pPool) {
+    Random random(seed);
+    std::vector<Region> regions;
+    pushRegion(regions, maze);
+
+    size_t head = 0;
+    while (head < regions.size() && regions.size() - head < independentRegions) {
+        Region region = regions[head++]; // Copied, dividing it grows regions.
+        divideRegion(tiles, stride, region, random, regions);
+    }
+
+    auto divideRegions = [&](size_t begin, size_t end) {
+        std::vector<Region> stack;
+        for (size_t i = head + begin; i < head + end; i++) {
+            Random regionRandom(seed + 0x9e3779b97f4a7c15ull * (i + 1));
+            stack.push_back(regions[i]);
+            while (!stack.empty()) {
+                Region region = stack.back();
+                stack.pop_back();
+                divideRegion(tiles, stride, region, regionRandom, stack);
+            }
+        }
+    };
+
+    if (pPool != nullptr)
+        pPool->parallelFor(regions.size() - head, 1, divideRegions);
+    else
+        divideRegions(0, regions.size() - head);
+}
+
+// Regions always span odd to odd coordinates, walls go on even ones and holes on odd ones.
+// Only tiles inside the region are written, so disjoint regions can be divided in parallel.
+void MazeGenerator::divideRegion(uint8_t *tiles, size_t stride, const Region &region, Random &random, std::vector<Region> &regions) {
+    int xRange = region.x2 - region.x1, yRange = region.y2 - region.y1;
+
+    if (xRange <= yRange) {
+        // Pick one of the yRange / 2 even y coords and one of the xRange / 2 + 1 odd x coords.
+        int wallPosition = region.y1 + 1 + 2 * random.inRange(0, yRange / 2 - 1);
+        int holePosition = region.x1 + 2 * random.inRange(0, xRange / 2);
+
+        // Rows are contiguous.
+        uint8_t *row = &tiles[(size_t)wallPosition * stride];
+        std::fill(row + region.x1, row + region.x2 + 1, (uint8_t)Wall);
+        row[holePosition] = Empty;
+
+        pushRegion(regions, {region.x1, wallPosition + 1, region.x2, region.y2});
+        pushRegion(regions, {region.x1, region.y1, region.x2, wallPosition - 1});
+    } else {
+        int wallPosition = region.x1 + 1 + 2 * random.inRange(0, xRange / 2 - 1);
+        int holePosition = region.y1 + 2 * random.inRange(0, yRange / 2);
+
+        uint8_t *column = &tiles[(size_t)wallPosition];
+        for (int i = region.y1; i <= region.y2; i++) {
+            column[(size_t)i * stride] = Wall;
+        }
+        column[(size_t)holePosition * stride] = Empty;
+
+        pushRegion(regions, {wallPosition + 1, region.y1, region.x2, region.y2});
+        pushRegion(regions, {region.x1, region.y1, wallPosition - 1, region.y2});
+    }
+}
+
+void MazeGenerator::pushRegion(std::vector<Region> &regions, const Region &region) {
+    // Regions one cell thin cannot be divided, about half of all regions, so they are never stored.
+    if (region.x2 > region.x1 && region.y2 > region.y1) regions.push_back(region);
+}
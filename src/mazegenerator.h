@@ -0,0 +1,39 @@
+#ifndef mazegeneratorH
+#define mazegeneratorH
+
+#include <cstdint>
+#include <vector>
+
+#include "random.h"
+#include "threadpool.h"
+
+// Tile ids stored in the map.
+enum Tile : uint8_t {
+    Empty = 0,
+    Wall = 1,
+    Exit = 2,
+    Entrance = 3,
+    tileTypeCount
+};
+
+// Recursive division maze generator with explicit stacks, writes walls into a grid of tile ids.
+class MazeGenerator {
+public:
+    // Part of the maze still to be divided, inclusive bounds.
+    struct Region {
+        int x1, y1, x2, y2;
+    };
+
+    // Divide maze, which must be empty and span odd to odd coordinates, of a grid whose rows are stride tiles apart.
+    // Runs in parallel on pPool when it is given, the result depends only on the seed.
+    static void generate(uint8_t *tiles, size_t stride, const Region &maze, uint64_t seed, ThreadPool *pPool = nullptr);
+
+private:
+    static constexpr size_t independentRegions = 256; // Regions the work is split into.
+
+    // Split region by a wall with one hole and push the parts that can be divided further.
+    static void divideRegion(uint8_t *tiles, size_t stride, const Region &region, Random &random, std::vector<Region> &regions);
+    static void pushRegion(std::vector<Region> &regions, const Region &region);
+};
+
+#endif
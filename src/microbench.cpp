@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+#include "map.h"
+#include "mazegenerator.h"
+#include "player.h"
+#include "renderer.h"
+#include "texture.h"
+
+// Microbenchmarks of single components, need no display.
+// Every case runs warmup untimed samples, then repeat timed samples of batch operations each,
+// and reports time per operation. --json also writes the results for comparing runs by script.
+// Usage: ./microbench [--warmup 3] [--repeat 15] [--filter texture|map|collision|column] [--json results.json]
+
+namespace {
+// Statistics of one case in nanoseconds per operation.
+struct Measurement {
+    std::string group, name;
+    size_t batch, samples;
+    double mean, median, min, max, stddev;
+};
+
+class Suite {
+    size_t warmup, repeat;
+    std::string filter;
+    std::vector<Measurement> results;
+
+public:
+    Suite(size_t warmupSamples, size_t repeatSamples, std::string groupFilter) : warmup(warmupSamples), repeat(repeatSamples), filter(groupFilter) {}
+
+    bool wants(const std::string &group) const { return filter.empty() || filter == group; }
+
+    // Time batch calls of operation per sample.
+    void measure(const std::string &group, const std::string &name, size_t batch, const std::function<void()> &operation) {
+        if (!wants(group)) return;
+
+        std::vector<double> times;
+        for (size_t sample = 0; sample < warmup + repeat; sample++) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < batch; i++) {
+                operation();
+            }
+            double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (double)batch;
+            if (sample >= warmup) times.push_back(time);
+        }
+
+        std::sort(times.begin(), times.end());
+        double total = 0, squares = 0;
+        for (double time : times)
+            total += time;
+        double mean = total / (double)times.size();
+        for (double time : times)
+            squares += (time - mean) * (time - mean);
+
+        Measurement result = {group, name, batch, times.size(), mean, times[times.size() / 2], times.front(), times.back(), std::sqrt(squares / (double)times.size())};
+        std::cout << std::left << std::setw(11) << group << std::setw(30) << name << std::right << std::setw(14) << result.median
+                  << std::setw(14) << result.mean << std::setw(14) << result.min << std::setw(10) << 100.0 * result.stddev / result.mean << "%" << std::endl;
+        results.push_back(result);
+    }
+
+    // s quoted as a JSON string.
+    static std::string jsonString(const std::string &s) {
+        std::string quoted = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+                quoted += c;
+            } else if ((unsigned char)c < 0x20) {
+                char escape[7];
+                snprintf(escape, sizeof(escape), "\\u%04x", (unsigned int)(unsigned char)c);
+                quoted += escape;
+            } else {
+                quoted += c;
+            }
+        }
+        return quoted + "\"";
+    }
+
+    bool writeJson(const std::string &filePath) const {
+        std::ofstream file(filePath);
+        if (!file) return false;
+
+        file << std::setprecision(6) << "{\n\"warmup\": " << warmup << ",\n\"repeat\": " << repeat << ",\n\"unit\": \"ns/op\",\n\"results\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Measurement &result = results[i];
+            file << (i ? "," : "") << "\n{\"group\": " << jsonString(result.group) << ", \"name\": " << jsonString(result.name) << ", \"batch\": " << result.batch
+                 << ", \"samples\": " << result.samples << ", \"mean\": " << result.mean << ", \"median\": " << result.median
+                 << ", \"min\": " << result.min << ", \"max\": " << result.max << ", \"stddev\": " << result.stddev << "}";
+        }
+        file << "\n]\n}\n";
+        return (bool)file;
+    }
+};
+
+// Every texture file, P3 and P6 alike, loaded from scratch without the texture cache.
+void benchTextures(Suite &suite) {
+    std::vector<std::filesystem::path> files;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator("../textures")) {
+        if (entry.path().extension() == ".ppm") files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    for (const std::filesystem::path &file : files) {
+        std::ifstream header(file);
+        std::string magic;
+        header >> magic;
+        suite.measure("texture", file.filename().string() + " (" + magic + ")", 1, [&]() { Texture texture(file.string()); });
+    }
+}
+
+// Mazes come from a fixed seed, so every sample and every run builds the same one. The generate cases time
+// MazeGenerator alone on a cleared grid, the construct cases a whole Map, which also builds its occupancy bits
+// and texture atlas. Wall distances are built later, as rays reach them.
+void benchMapGeneration(Suite &suite) {
+    for (int size : {11, 101, 1001}) {
+        std::string name = std::to_string(size) + "x" + std::to_string(size);
+        size_t batch = size < 1000 ? 20 : 1;
+        std::vector<uint8_t> tiles((size_t)(size + 2) * (size_t)(size + 2));
+        suite.measure("map", "generate " + name, batch, [&]() {
+            std::fill(tiles.begin(), tiles.end(), Empty);
+            MazeGenerator::generate(tiles.data(), (size_t)size + 2, {1, 1, size, size}, 1);
+        });
+        suite.measure("map", "construct " + name, batch, [&]() { Map map(size, size, 1); });
+    }
+}
+
+// Walking forward while turning runs into walls and slides along them, so most moves test several cells.
+void benchCollision(Suite &suite) {
+    srand(1);
+    Map map(51, 51);
+    Player player(1.5f, 1.5f, 0.f);
+    PlayerInput input;
+    input.keys = PlayerInput::Forward | PlayerInput::Left;
+    suite.measure("collision", "moveRelative in 51x51 maze", 100000, [&]() { player.movement(input, 8.f, map); });
+}
+
+// One screen column cast and drawn, with the camera facing a wall at several distances in an empty room.
+void benchColumn(Suite &suite) {
+    if (!suite.wants("column")) return;
+
+    Map map(129, 129, 1);
+    for (int y = 1; y < map.getHeight() - 1; y++) {
+        for (int x = 1; x < map.getWidth() - 1; x++) {
+            map.setTile(x, y, Empty);
+        }
+    }
+    Texture sky("../textures/skyTexture2P6.ppm");
+    FrameBuffer column(1, 720);
+    Renderer renderer(1);
+
+    // 90 degrees faces positive x, towards the wall at the right edge.
+    float wallX = (float)(map.getWidth() - 1);
+    for (float distance : {1.f, 4.f, 16.f, 64.f, 128.f}) {
+        suite.measure("column", "wall at " + std::to_string((int)distance), 10000, [&]() {
+            renderer.renderFrame(column, map, sky, wallX - distance, (float)map.getHeight() / 2.f, 90.f);
+        });
+    }
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    std::map<std::string, std::string> options = {{"warmup", "3"}, {"repeat", "15"}, {"filter", ""}, {"json", ""}};
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.rfind("--", 0) != 0 || !options.count(key.substr(2))) {
+            std::cerr << "Unknown option " << key << std::endl;
+            return 1;
+        }
+        options[key.substr(2)] = argv[i + 1];
+    }
+
+    Suite suite(std::stoul(options["warmup"]), std::max(std::stoul(options["repeat"]), 1ul), options["filter"]);
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(41) << "case" << std::right << std::setw(14) << "median ns" << std::setw(14) << "mean ns"
+              << std::setw(14) << "min ns" << std::setw(11) << "stddev" << std::endl;
+
+    if (suite.wants("texture")) benchTextures(suite);
+    if (suite.wants("map")) benchMapGeneration(suite);
+    if (suite.wants("collision")) benchCollision(suite);
+    benchColumn(suite);
+
+    if (!options["json"].empty()) {
+        if (!suite.writeJson(options["json"])) {
+            std::cerr << "Cannot write " << options["json"] << std::endl;
+            return 1;
+        }
+        std::cout << "results written to " << options["json"] << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <algorithm>
+
+#include "minimap.h"
+#include "profiler.h"
+
+const sf::Color Minimap::visitedColor = sf::Color(160, 190, 255);
+
+void Minimap::reset() {
+    layer.clear();
+    layerWidth = layerHeight = 0;
+    visited.clear();
+    lastX = lastY = -1;
+}
+
+bool Minimap::visit(const Map &map, int x, int y) {
+    if ((x == lastX && y == lastY) || map.getTile(x, y) != Empty) return false;
+    lastX = x;
+    lastY = y;
+
+    if (!visited.insert(getKey(x, y)).second) return false;
+    if (x >= layerX && x < layerX + layerWidth && y >= layerY && y < layerY + layerHeight)
+        layer[(size_t)(y - layerY) * (size_t)layerWidth + (size_t)(x - layerX)] = toPixel(visitedColor);
+    return true;
+}
+
+void Minimap::draw(FrameBuffer &frameBuffer, const Map &map, float playerX, float playerY, int cellScale, int maxCellsX, int maxCellsY) {
+    // Only the cells fitting in the minimap, centered on the player when the maze is bigger.
+    int cellsX = std::min(map.getWidth(), maxCellsX);
+    int cellsY = std::min(map.getHeight(), maxCellsY);
+    int firstX = std::clamp((int)playerX - cellsX / 2, 0, map.getWidth() - cellsX);
+    int firstY = std::clamp((int)playerY - cellsY / 2, 0, map.getHeight() - cellsY);
+
+    if (firstX < layerX || firstY < layerY || firstX + cellsX > layerX + layerWidth || firstY + cellsY > layerY + layerHeight) {
+        // Half a view of margin on every side, so walking across the view rebuilds the layer only once.
+        int width = std::min(map.getWidth(), cellsX * 2), height = std::min(map.getHeight(), cellsY * 2);
+        cacheLayer(map, std::clamp(firstX - cellsX / 2, 0, map.getWidth() - width), std::clamp(firstY - cellsY / 2, 0, map.getHeight() - height), width, height);
+    }
+
+    const Pixel *pView = layer.data() + (size_t)(firstY - layerY) * (size_t)layerWidth + (size_t)(firstX - layerX);
+    frameBuffer.drawScaledImage(0, 0, pView, (size_t)layerWidth, (size_t)cellsX, (size_t)cellsY, cellScale);
+
+    Pixel marker = toPixel(sf::Color::Blue);
+    frameBuffer.drawScaledImage(((int)playerX - firstX) * cellScale, ((int)playerY - firstY) * cellScale, &marker, 1, 1, 1, cellScale);
+}
+
+void Minimap::cacheLayer(const Map &map, int x, int y, int width, int height) {
+    PROFILE_SCOPE("minimap layer");
+    layerX = x;
+    layerY = y;
+    layerWidth = width;
+    layerHeight = height;
+    layer.resize((size_t)width * (size_t)height);
+
+    Pixel visitedPixel = toPixel(visitedColor);
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            bool wasVisited = !visited.empty() && visited.contains(getKey(x + i, y + j));
+            layer[(size_t)j * (size_t)width + (size_t)i] = wasVisited ? visitedPixel : toPixel(map.getTileColor(x + i, y + j));
+        }
+    }
+}
+
+uint64_t Minimap::getKey(int x, int y) { return (uint64_t)(uint32_t)x << 32 | (uint32_t)y; }
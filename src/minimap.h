@@ -0,0 +1,41 @@
+#ifndef minimapH
+#define minimapH
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "framebuffer.h"
+#include "map.h"
+
+// Minimap of the cells around the player, drawn in the bottom left corner of the frame.
+// Cells are colored into a cached layer once, covering the visible cells and a margin around them,
+// so a frame only blits the layer and the player marker. The layer is rebuilt when the view scrolls
+// out of it, which keeps the cost bounded by the view size however big the maze is.
+class Minimap {
+    static const sf::Color visitedColor;
+
+    std::vector<Pixel> layer;                                   // One pixel per cell, rows from the bottom.
+    int layerX = 0, layerY = 0, layerWidth = 0, layerHeight = 0; // Cells covered by layer.
+    std::unordered_set<uint64_t> visited;                       // Cells the player has been in.
+    int lastX = -1, lastY = -1;
+
+public:
+    // Forget the layer and the visited cells, for a new maze.
+    void reset();
+
+    // Mark the empty cell at (x, y) as visited, updating the layer when the cell is in it.
+    // Returns whether this is the first visit of the cell.
+    bool visit(const Map &map, int x, int y);
+
+    // Draw the cells around (playerX, playerY), at most maxCellsX x maxCellsY of them with cellScale pixels per cell.
+    void draw(FrameBuffer &frameBuffer, const Map &map, float playerX, float playerY, int cellScale, int maxCellsX, int maxCellsY);
+
+private:
+    // Color the cells of the layer, which covers width x height cells starting at (x, y).
+    void cacheLayer(const Map &map, int x, int y, int width, int height);
+
+    static uint64_t getKey(int x, int y);
+};
+
+#endif
@@ -0,0 +1,479 @@
+#include "packetcaster.h"
+
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PACKET_CASTER_X86
+#endif
+
+RayCastingIsa PacketCaster::getBestIsa() {
+    if (isSupported(RayCastingIsa::AVX512)) return RayCastingIsa::AVX512;
+    if (isSupported(RayCastingIsa::AVX2)) return RayCastingIsa::AVX2;
+    return RayCastingIsa::Scalar;
+}
+
+bool PacketCaster::isSupported(RayCastingIsa isa) {
+    switch (isa) {
+#ifdef PACKET_CASTER_X86
+    case RayCastingIsa::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case RayCastingIsa::AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    case RayCastingIsa::Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char *PacketCaster::getName(RayCastingIsa isa) {
+    switch (isa) {
+    case RayCastingIsa::AVX2:
+        return "avx2";
+    case RayCastingIsa::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+bool PacketCaster::canCast(const Map &map) {
+    // Cell indices are computed in 32 bit lanes.
+    return map.getSolidBits() != nullptr && (long long)map.getWidth() * map.getHeight() <= INT_MAX;
+}
+
+__attribute__((noinline)) RayStart PacketCaster::startRay(float originX, float originY, float dirX, float dirY) {
+    RayStart start;
+    int cellX = (int)originX, cellY = (int)originY;
+
+    // Axis parallel rays never cross the other axis, a huge value keeps them from choosing it.
+    start.deltaX = fabsf(dirX) > 1e-6f ? fabsf(1.f / dirX) : 1e30f;
+    start.deltaY = fabsf(dirY) > 1e-6f ? fabsf(1.f / dirY) : 1e30f;
+
+    start.sideX = (dirX < 0 ? originX - (float)cellX : (float)cellX + 1.f - originX) * start.deltaX;
+    start.sideY = (dirY < 0 ? originY - (float)cellY : (float)cellY + 1.f - originY) * start.deltaY;
+    return start;
+}
+
+void PacketCaster::castDDA(RayCastingIsa isa, const RayPacket &packet, const Map &map, std::array<RayHit, RayPacket::maxRays> &hits, bool skipEmpty) {
+    // Unused lanes get valid rays too, so no lane computes with garbage.
+    PacketStart start;
+    for (size_t i = 0; i < RayPacket::maxRays; i++) {
+        RayStart ray = i < packet.count ? startRay(packet.originX, packet.originY, packet.dirX[i], packet.dirY[i]) : RayStart{1.f, 1.f, 1.f, 1.f};
+        start.deltaX[i] = ray.deltaX;
+        start.deltaY[i] = ray.deltaY;
+        start.sideX[i] = ray.sideX;
+        start.sideY[i] = ray.sideY;
+    }
+
+    if (isa == RayCastingIsa::AVX512) {
+        castDDAAVX512(packet, start, map, skipEmpty, hits.data());
+    } else if (isa == RayCastingIsa::AVX2) {
+        for (size_t first = 0; first < packet.count; first += 8) {
+            castDDAAVX2(packet, start, first, map, skipEmpty, &hits[first]);
+        }
+    } else {
+        throw std::invalid_argument("packets need a SIMD instruction set");
+    }
+}
+
+#ifdef PACKET_CASTER_X86
+
+// Boundary n of the axis whose first boundary is at side, the way Renderer::castRayDDA computes it.
+__attribute__((target("avx2"), always_inline)) static inline __m256 boundaryAVX2(__m256 side, __m256 delta, __m256i n) {
+    return _mm256_add_ps(side, _mm256_mul_ps(_mm256_cvtepi32_ps(n), delta));
+}
+
+// Whether at comes before limit in strict lanes, or at most reaches it in the others.
+__attribute__((target("avx2"), always_inline)) static inline __m256i beforeLimitAVX2(__m256 at, __m256 limit, __m256i strict) {
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_cmp_ps(at, limit, _CMP_LE_OQ), _mm256_cmp_ps(at, limit, _CMP_LT_OQ), _mm256_castsi256_ps(strict)));
+}
+
+// Lanes that stepped along x keep their own hitFromX, so a mask is kept per lane and blended in.
+// Occupancy words are gathered as 32 bit halves of the 64 bit words, x86 is little endian.
+// Lanes enter and jump across the empty space around the cells they look up like in Renderer::castRayDDA, the
+// boundaries jumping lanes cross are estimated and corrected for all of them at once, while the other lanes step.
+// Only lanes that left the known empty space gather, and only those that entered an empty cell read its wall
+// distances, one lane at a time since they are built as rays reach them.
+__attribute__((target("avx2"))) void PacketCaster::castDDAAVX2(const RayPacket &packet, const PacketStart &start, size_t first, const Map &map, bool skipEmpty, RayHit *hits) {
+    const int *solidWords = reinterpret_cast<const int *>(map.getSolidBits());
+    const __m256 one = _mm256_set1_ps(1.f), zero = _mm256_setzero_ps();
+    const __m256i zeroInt = _mm256_setzero_si256(), oneInt = _mm256_set1_epi32(1), width = _mm256_set1_epi32(map.getWidth());
+
+    int startX = (int)packet.originX, startY = (int)packet.originY;
+    __m256 originX = _mm256_set1_ps(packet.originX), originY = _mm256_set1_ps(packet.originY);
+    __m256 dirX = _mm256_load_ps(&packet.dirX[first]), dirY = _mm256_load_ps(&packet.dirY[first]);
+
+    // Lanes past the end of the packet start out finished.
+    __m256i active = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(packet.count - first)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    __m256 deltaX = _mm256_load_ps(&start.deltaX[first]), deltaY = _mm256_load_ps(&start.deltaY[first]);
+    __m256 sideX = _mm256_load_ps(&start.sideX[first]), sideY = _mm256_load_ps(&start.sideY[first]);
+    __m256 negativeY = _mm256_cmp_ps(dirY, zero, _CMP_LT_OQ);
+    __m256i stepX = _mm256_or_si256(_mm256_castps_si256(_mm256_cmp_ps(dirX, zero, _CMP_LT_OQ)), oneInt); // -1 or 1.
+    __m256i stepY = _mm256_or_si256(_mm256_castps_si256(negativeY), oneInt);
+
+    __m256i cellX = _mm256_set1_epi32(startX), cellY = _mm256_set1_epi32(startY), steps = zeroInt, cells = zeroInt, moves = zeroInt;
+    __m256i stepsX = zeroInt, stepsY = zeroInt; // Boundaries crossed along each axis.
+    __m256 distance = zero, hitFromX = zero;
+
+    // Bit offsets of each lane's runs in the WallDistances words: posX or negX, posY or negY.
+    const __m256i runMask = _mm256_set1_epi32((int)WallDistances::maxRun);
+    __m256i shiftX = _mm256_and_si256(_mm256_srai_epi32(stepX, 1), _mm256_set1_epi32(WallDistances::negX));
+    __m256i shiftY = _mm256_add_epi32(_mm256_and_si256(_mm256_srai_epi32(stepY, 1), _mm256_set1_epi32(WallDistances::negY - WallDistances::posY)), _mm256_set1_epi32(WallDistances::posY));
+    // Empty space around the cell each lane looked up last, and the boundaries it had crossed then. A radius of -1
+    // leaves nothing known without skipping. Lanes whose square is wide enough to jump across are pending.
+    const __m256i minJump = _mm256_set1_epi32(minJumpRadius);
+    __m256i runX = zeroInt, runY = zeroInt, radius = _mm256_set1_epi32(-1), lookedUpX = zeroInt, lookedUpY = zeroInt, pending = zeroInt;
+    if (skipEmpty) {
+        __m256i word = _mm256_set1_epi32(map.getWallDistances(startX, startY));
+        runX = _mm256_and_si256(_mm256_srlv_epi32(word, shiftX), runMask);
+        runY = _mm256_and_si256(_mm256_srlv_epi32(word, shiftY), runMask);
+        radius = _mm256_srli_epi32(word, WallDistances::radius);
+        pending = _mm256_andnot_si256(_mm256_cmpgt_epi32(minJump, radius), active);
+    }
+
+    // Every active lane jumps or steps to its closer boundary, lanes drop out once they enter a wall.
+    __m256 nextX = boundaryAVX2(sideX, deltaX, stepsX), nextY = boundaryAVX2(sideY, deltaY, stepsY);
+    while (!_mm256_testz_si256(active, active)) {
+        // Computed before the axes are chosen, so the next comparison waits on blends only.
+        __m256 afterX = boundaryAVX2(sideX, deltaX, _mm256_add_epi32(stepsX, oneInt)), afterY = boundaryAVX2(sideY, deltaY, _mm256_add_epi32(stepsY, oneInt));
+
+        __m256i jumped = zeroInt;
+        if (!_mm256_testz_si256(pending, pending)) {
+            __m256 rowX = boundaryAVX2(sideX, deltaX, _mm256_add_epi32(stepsX, runX)), columnY = boundaryAVX2(sideY, deltaY, _mm256_add_epi32(stepsY, runY));
+            __m256 squareX = boundaryAVX2(sideX, deltaX, _mm256_add_epi32(stepsX, radius)), squareY = boundaryAVX2(sideY, deltaY, _mm256_add_epi32(stepsY, radius));
+            __m256 leaveRow = _mm256_min_ps(rowX, nextY), leaveColumn = _mm256_min_ps(nextX, columnY), leaveSquare = _mm256_min_ps(squareX, squareY);
+
+            // Each lane crosses the row, the column or the square around its cell, whichever it leaves last.
+            __m256 notSquare = _mm256_or_ps(_mm256_cmp_ps(leaveSquare, leaveRow, _CMP_LT_OQ), _mm256_cmp_ps(leaveSquare, leaveColumn, _CMP_LT_OQ));
+            __m256 row = _mm256_cmp_ps(leaveRow, leaveColumn, _CMP_GE_OQ);
+            __m256 useRow = _mm256_and_ps(notSquare, row), useColumn = _mm256_andnot_ps(row, notSquare);
+            __m256i extentX = _mm256_andnot_si256(_mm256_castps_si256(useColumn), _mm256_blendv_epi8(radius, runX, _mm256_castps_si256(useRow)));
+            __m256i extentY = _mm256_andnot_si256(_mm256_castps_si256(useRow), _mm256_blendv_epi8(radius, runY, _mm256_castps_si256(useColumn)));
+            __m256 exitX = _mm256_blendv_ps(_mm256_blendv_ps(squareX, rowX, useRow), nextX, useColumn);
+            __m256 exitY = _mm256_blendv_ps(_mm256_blendv_ps(squareY, nextY, useRow), columnY, useColumn);
+
+            // Leaving through an x boundary crosses all x boundaries before it and the y boundaries up to it.
+            __m256 leaveX = _mm256_cmp_ps(exitX, exitY, _CMP_LT_OQ);
+            __m256i countX = _mm256_castps_si256(_mm256_xor_ps(leaveX, _mm256_castsi256_ps(_mm256_set1_epi32(-1))));
+            __m256 side = _mm256_blendv_ps(sideX, sideY, leaveX), delta = _mm256_blendv_ps(deltaX, deltaY, leaveX), limit = _mm256_blendv_ps(exitY, exitX, leaveX);
+            __m256i taken = _mm256_blendv_epi8(stepsX, stepsY, _mm256_castps_si256(leaveX)), cap = _mm256_blendv_epi8(extentX, extentY, _mm256_castps_si256(leaveX));
+            __m256 estimate = _mm256_sub_ps(_mm256_ceil_ps(_mm256_div_ps(_mm256_sub_ps(limit, side), delta)), _mm256_cvtepi32_ps(taken));
+            __m256i count = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(estimate, zero), _mm256_cvtepi32_ps(cap))), pending);
+            // Masks are -1, so adding them counts down and subtracting them counts up.
+            __m256i fewer = _mm256_andnot_si256(beforeLimitAVX2(boundaryAVX2(side, delta, _mm256_sub_epi32(_mm256_add_epi32(taken, count), oneInt)), limit, countX), _mm256_and_si256(pending, _mm256_cmpgt_epi32(count, zeroInt)));
+            while (!_mm256_testz_si256(fewer, fewer)) {
+                count = _mm256_add_epi32(count, fewer);
+                fewer = _mm256_andnot_si256(beforeLimitAVX2(boundaryAVX2(side, delta, _mm256_sub_epi32(_mm256_add_epi32(taken, count), oneInt)), limit, countX), _mm256_and_si256(fewer, _mm256_cmpgt_epi32(count, zeroInt)));
+            }
+            __m256i more = _mm256_and_si256(beforeLimitAVX2(boundaryAVX2(side, delta, _mm256_add_epi32(taken, count)), limit, countX), _mm256_and_si256(pending, _mm256_cmpgt_epi32(cap, count)));
+            while (!_mm256_testz_si256(more, more)) {
+                count = _mm256_sub_epi32(count, more);
+                more = _mm256_and_si256(beforeLimitAVX2(boundaryAVX2(side, delta, _mm256_add_epi32(taken, count)), limit, countX), _mm256_and_si256(more, _mm256_cmpgt_epi32(cap, count)));
+            }
+            __m256i crossedX = _mm256_blendv_epi8(count, extentX, _mm256_castps_si256(leaveX)), crossedY = _mm256_blendv_epi8(extentY, count, _mm256_castps_si256(leaveX));
+            __m256i crossed = _mm256_add_epi32(crossedX, crossedY);
+            jumped = _mm256_and_si256(pending, _mm256_cmpgt_epi32(crossed, zeroInt));
+            crossedX = _mm256_and_si256(crossedX, jumped);
+            crossedY = _mm256_and_si256(crossedY, jumped);
+
+            // The last boundary crossed, y ones come first on a tie.
+            __m256 lastX = boundaryAVX2(sideX, deltaX, _mm256_sub_epi32(_mm256_add_epi32(stepsX, crossedX), oneInt));
+            __m256 lastY = boundaryAVX2(sideY, deltaY, _mm256_sub_epi32(_mm256_add_epi32(stepsY, crossedY), oneInt));
+            __m256i lastAlongX = _mm256_or_si256(_mm256_cmpeq_epi32(crossedY, zeroInt), _mm256_castps_si256(_mm256_cmp_ps(lastX, lastY, _CMP_GE_OQ)));
+            __m256 fromX = _mm256_castsi256_ps(_mm256_andnot_si256(_mm256_cmpeq_epi32(crossedX, zeroInt), lastAlongX));
+            __m256 jumpedMask = _mm256_castsi256_ps(jumped);
+            distance = _mm256_blendv_ps(distance, _mm256_blendv_ps(lastY, lastX, fromX), jumpedMask);
+            hitFromX = _mm256_blendv_ps(hitFromX, fromX, jumpedMask);
+            stepsX = _mm256_add_epi32(stepsX, crossedX);
+            stepsY = _mm256_add_epi32(stepsY, crossedY);
+            cellX = _mm256_add_epi32(cellX, _mm256_sign_epi32(crossedX, stepX));
+            cellY = _mm256_add_epi32(cellY, _mm256_sign_epi32(crossedY, stepY));
+            cells = _mm256_add_epi32(cells, _mm256_and_si256(crossed, jumped));
+            moves = _mm256_sub_epi32(moves, jumped);
+            nextX = _mm256_blendv_ps(nextX, boundaryAVX2(sideX, deltaX, stepsX), jumpedMask);
+            nextY = _mm256_blendv_ps(nextY, boundaryAVX2(sideY, deltaY, stepsY), jumpedMask);
+            pending = zeroInt;
+        }
+
+        // Masks are -1, so subtracting them counts up.
+        __m256i step = _mm256_andnot_si256(jumped, active);
+        if (_mm256_testz_si256(step, step)) continue;
+        __m256 stepMask = _mm256_castsi256_ps(step);
+        __m256 closerX = _mm256_cmp_ps(nextX, nextY, _CMP_LT_OQ);
+        __m256 moveX = _mm256_and_ps(closerX, stepMask), moveY = _mm256_andnot_ps(closerX, stepMask);
+        __m256i movedX = _mm256_castps_si256(moveX), movedY = _mm256_castps_si256(moveY);
+
+        distance = _mm256_blendv_ps(distance, nextX, moveX);
+        distance = _mm256_blendv_ps(distance, nextY, moveY);
+        nextX = _mm256_blendv_ps(nextX, afterX, moveX);
+        nextY = _mm256_blendv_ps(nextY, afterY, moveY);
+        stepsX = _mm256_sub_epi32(stepsX, movedX);
+        stepsY = _mm256_sub_epi32(stepsY, movedY);
+        cellX = _mm256_add_epi32(cellX, _mm256_and_si256(stepX, movedX));
+        cellY = _mm256_add_epi32(cellY, _mm256_and_si256(stepY, movedY));
+        hitFromX = _mm256_blendv_ps(hitFromX, closerX, stepMask);
+        cells = _mm256_sub_epi32(cells, step);
+        moves = _mm256_sub_epi32(moves, step);
+
+        // Lanes still in the empty row, column or square around the cell they looked up last need no lookup.
+        __m256i aheadX = _mm256_sub_epi32(stepsX, lookedUpX), aheadY = _mm256_sub_epi32(stepsY, lookedUpY);
+        __m256i inRow = _mm256_andnot_si256(_mm256_cmpgt_epi32(aheadX, runX), _mm256_cmpeq_epi32(aheadY, zeroInt));
+        __m256i inColumn = _mm256_andnot_si256(_mm256_cmpgt_epi32(aheadY, runY), _mm256_cmpeq_epi32(aheadX, zeroInt));
+        __m256i outsideSquare = _mm256_or_si256(_mm256_cmpgt_epi32(aheadX, radius), _mm256_cmpgt_epi32(aheadY, radius));
+        __m256i lookup = _mm256_andnot_si256(_mm256_or_si256(inRow, inColumn), _mm256_and_si256(outsideSquare, step));
+        if (_mm256_testz_si256(lookup, lookup)) continue;
+        steps = _mm256_sub_epi32(steps, lookup);
+
+        __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(cellY, width), cellX);
+        __m256i solidWordsOfCells = _mm256_mask_i32gather_epi32(zeroInt, solidWords, _mm256_srli_epi32(cell, 5), lookup, 4);
+        __m256i solid = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srlv_epi32(solidWordsOfCells, _mm256_and_si256(cell, _mm256_set1_epi32(31))), oneInt), oneInt), lookup);
+        active = _mm256_andnot_si256(solid, active);
+
+        __m256i load = _mm256_andnot_si256(solid, lookup);
+        if (skipEmpty && !_mm256_testz_si256(load, load)) {
+            alignas(32) int xs[8], ys[8], loaded[8] = {};
+            _mm256_store_si256(reinterpret_cast<__m256i *>(xs), cellX);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(ys), cellY);
+            for (unsigned lanes = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(load)); lanes != 0; lanes &= lanes - 1) {
+                int i = __builtin_ctz(lanes);
+                loaded[i] = map.getWallDistances(xs[i], ys[i]);
+            }
+            __m256i words = _mm256_load_si256(reinterpret_cast<const __m256i *>(loaded));
+            runX = _mm256_blendv_epi8(runX, _mm256_and_si256(_mm256_srlv_epi32(words, shiftX), runMask), load);
+            runY = _mm256_blendv_epi8(runY, _mm256_and_si256(_mm256_srlv_epi32(words, shiftY), runMask), load);
+            radius = _mm256_blendv_epi8(radius, _mm256_srli_epi32(words, WallDistances::radius), load);
+            lookedUpX = _mm256_blendv_epi8(lookedUpX, stepsX, load);
+            lookedUpY = _mm256_blendv_epi8(lookedUpY, stepsY, load);
+            pending = _mm256_andnot_si256(_mm256_cmpgt_epi32(minJump, radius), load);
+        }
+    }
+
+    __m256 x = _mm256_add_ps(originX, _mm256_mul_ps(dirX, distance));
+    __m256 y = _mm256_add_ps(originY, _mm256_mul_ps(dirY, distance));
+
+    // Position along the wall face, flipped so textures are never mirrored.
+    __m256 alongX = _mm256_sub_ps(y, _mm256_floor_ps(y));
+    alongX = _mm256_blendv_ps(alongX, _mm256_sub_ps(one, alongX), _mm256_cmp_ps(dirX, zero, _CMP_GT_OQ));
+    __m256 alongY = _mm256_sub_ps(x, _mm256_floor_ps(x));
+    alongY = _mm256_blendv_ps(alongY, _mm256_sub_ps(one, alongY), negativeY);
+    __m256 textureX = _mm256_blendv_ps(alongY, alongX, hitFromX);
+
+    alignas(32) float xs[8], ys[8], distances[8], textureXs[8];
+    alignas(32) int cellXs[8], cellYs[8], stepCounts[8], cellCounts[8], moveCounts[8], fromX[8];
+    _mm256_store_ps(xs, x);
+    _mm256_store_ps(ys, y);
+    _mm256_store_ps(distances, distance);
+    _mm256_store_ps(textureXs, textureX);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(cellXs), cellX);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(cellYs), cellY);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(stepCounts), steps);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(cellCounts), cells);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(moveCounts), moves);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(fromX), _mm256_castps_si256(hitFromX));
+
+    for (size_t i = 0; i < 8 && first + i < packet.count; i++) {
+        hits[i] = {xs[i], ys[i], distances[i], textureXs[i], cellXs[i], cellYs[i], fromX[i] != 0, (unsigned int)stepCounts[i], (unsigned int)cellCounts[i], (unsigned int)moveCounts[i]};
+    }
+}
+
+// Boundary n of the axis whose first boundary is at side. AVX-512 implies FMA, explicit rounding keeps the compiler
+// from fusing this into a differently rounded result. Zero masked for the same header warning as the shifts below.
+__attribute__((target("avx512f"), always_inline)) static inline __m512 boundaryAVX512(__m512 side, __m512 delta, __m512i n) {
+    const __mmask16 allLanes = 0xffff;
+    return _mm512_maskz_add_round_ps(allLanes, side, _mm512_maskz_mul_round_ps(allLanes, _mm512_maskz_cvtepi32_ps(allLanes, n), delta, _MM_FROUND_CUR_DIRECTION), _MM_FROUND_CUR_DIRECTION);
+}
+
+// Lanes where at comes before limit among strict, or at most reaches it among the others.
+__attribute__((target("avx512f"), always_inline)) static inline __mmask16 beforeLimitAVX512(__m512 at, __m512 limit, __mmask16 strict) {
+    return (__mmask16)((_mm512_cmp_ps_mask(at, limit, _CMP_LT_OQ) & strict) | (_mm512_cmp_ps_mask(at, limit, _CMP_LE_OQ) & ~strict));
+}
+
+// Same traversal as castDDAAVX2 on 16 lanes, with mask registers instead of blend masks.
+__attribute__((target("avx512f"))) void PacketCaster::castDDAAVX512(const RayPacket &packet, const PacketStart &start, const Map &map, bool skipEmpty, RayHit *hits) {
+    const int *solidWords = reinterpret_cast<const int *>(map.getSolidBits());
+    const __m512 one = _mm512_set1_ps(1.f), zero = _mm512_setzero_ps();
+    const __m512i zeroInt = _mm512_setzero_si512(), oneInt = _mm512_set1_epi32(1), width = _mm512_set1_epi32(map.getWidth());
+    const __mmask16 allLanes = 0xffff; // For zero masked forms of unmasked operations, see boundaryAVX512.
+
+    int startX = (int)packet.originX, startY = (int)packet.originY;
+    __m512 originX = _mm512_set1_ps(packet.originX), originY = _mm512_set1_ps(packet.originY);
+    __m512 dirX = _mm512_load_ps(packet.dirX.data()), dirY = _mm512_load_ps(packet.dirY.data());
+
+    __mmask16 active = (__mmask16)((1u << packet.count) - 1);
+
+    __m512 deltaX = _mm512_load_ps(start.deltaX.data()), deltaY = _mm512_load_ps(start.deltaY.data());
+    __m512 sideX = _mm512_load_ps(start.sideX.data()), sideY = _mm512_load_ps(start.sideY.data());
+    __mmask16 negativeX = _mm512_cmp_ps_mask(dirX, zero, _CMP_LT_OQ), negativeY = _mm512_cmp_ps_mask(dirY, zero, _CMP_LT_OQ);
+    __m512i stepX = _mm512_mask_blend_epi32(negativeX, oneInt, _mm512_set1_epi32(-1));
+    __m512i stepY = _mm512_mask_blend_epi32(negativeY, oneInt, _mm512_set1_epi32(-1));
+
+    __m512i cellX = _mm512_set1_epi32(startX), cellY = _mm512_set1_epi32(startY), steps = zeroInt, cells = zeroInt, moves = zeroInt;
+    __m512i stepsX = zeroInt, stepsY = zeroInt;
+    __m512 distance = zero;
+    __mmask16 hitFromX = 0;
+
+    const __m512i runMask = _mm512_set1_epi32((int)WallDistances::maxRun);
+    __m512i shiftX = _mm512_mask_blend_epi32(negativeX, _mm512_set1_epi32(WallDistances::posX), _mm512_set1_epi32(WallDistances::negX));
+    __m512i shiftY = _mm512_mask_blend_epi32(negativeY, _mm512_set1_epi32(WallDistances::posY), _mm512_set1_epi32(WallDistances::negY));
+    const __m512i minJump = _mm512_set1_epi32(minJumpRadius);
+    __m512i runX = zeroInt, runY = zeroInt, radius = _mm512_set1_epi32(-1), lookedUpX = zeroInt, lookedUpY = zeroInt;
+    __mmask16 pending = 0;
+    if (skipEmpty) {
+        __m512i word = _mm512_set1_epi32(map.getWallDistances(startX, startY));
+        runX = _mm512_and_si512(_mm512_maskz_srlv_epi32(allLanes, word, shiftX), runMask);
+        runY = _mm512_and_si512(_mm512_maskz_srlv_epi32(allLanes, word, shiftY), runMask);
+        radius = _mm512_maskz_srli_epi32(allLanes, word, WallDistances::radius);
+        pending = (__mmask16)(active & ~_mm512_cmpgt_epi32_mask(minJump, radius));
+    }
+
+    __m512 nextX = boundaryAVX512(sideX, deltaX, stepsX), nextY = boundaryAVX512(sideY, deltaY, stepsY);
+    while (active) {
+        __m512 afterX = boundaryAVX512(sideX, deltaX, _mm512_add_epi32(stepsX, oneInt)), afterY = boundaryAVX512(sideY, deltaY, _mm512_add_epi32(stepsY, oneInt));
+
+        __mmask16 jumped = 0;
+        if (pending) {
+            __m512 rowX = boundaryAVX512(sideX, deltaX, _mm512_add_epi32(stepsX, runX)), columnY = boundaryAVX512(sideY, deltaY, _mm512_add_epi32(stepsY, runY));
+            __m512 squareX = boundaryAVX512(sideX, deltaX, _mm512_add_epi32(stepsX, radius)), squareY = boundaryAVX512(sideY, deltaY, _mm512_add_epi32(stepsY, radius));
+            __m512 leaveRow = _mm512_maskz_min_ps(allLanes, rowX, nextY), leaveColumn = _mm512_maskz_min_ps(allLanes, nextX, columnY), leaveSquare = _mm512_maskz_min_ps(allLanes, squareX, squareY);
+
+            __mmask16 notSquare = (__mmask16)(_mm512_cmp_ps_mask(leaveSquare, leaveRow, _CMP_LT_OQ) | _mm512_cmp_ps_mask(leaveSquare, leaveColumn, _CMP_LT_OQ));
+            __mmask16 row = _mm512_cmp_ps_mask(leaveRow, leaveColumn, _CMP_GE_OQ);
+            __mmask16 useRow = notSquare & row, useColumn = (__mmask16)(notSquare & ~row);
+            __m512i extentX = _mm512_maskz_mov_epi32((__mmask16)~useColumn, _mm512_mask_blend_epi32(useRow, radius, runX));
+            __m512i extentY = _mm512_maskz_mov_epi32((__mmask16)~useRow, _mm512_mask_blend_epi32(useColumn, radius, runY));
+            __m512 exitX = _mm512_mask_blend_ps(useColumn, _mm512_mask_blend_ps(useRow, squareX, rowX), nextX);
+            __m512 exitY = _mm512_mask_blend_ps(useColumn, _mm512_mask_blend_ps(useRow, squareY, nextY), columnY);
+
+            __mmask16 leaveX = _mm512_cmp_ps_mask(exitX, exitY, _CMP_LT_OQ), countX = (__mmask16)~leaveX;
+            __m512 side = _mm512_mask_blend_ps(leaveX, sideX, sideY), delta = _mm512_mask_blend_ps(leaveX, deltaX, deltaY), limit = _mm512_mask_blend_ps(leaveX, exitY, exitX);
+            __m512i taken = _mm512_mask_blend_epi32(leaveX, stepsX, stepsY), cap = _mm512_mask_blend_epi32(leaveX, extentX, extentY);
+            __m512 estimate = _mm512_sub_ps(_mm512_maskz_roundscale_ps(pending, _mm512_maskz_div_ps(pending, _mm512_sub_ps(limit, side), delta), _MM_FROUND_TO_POS_INF), _mm512_maskz_cvtepi32_ps(allLanes, taken));
+            __m512i count = _mm512_maskz_cvttps_epi32(pending, _mm512_maskz_min_ps(pending, _mm512_maskz_max_ps(pending, estimate, zero), _mm512_maskz_cvtepi32_ps(allLanes, cap)));
+            __mmask16 fewer = (__mmask16)(pending & _mm512_cmpgt_epi32_mask(count, zeroInt) & ~beforeLimitAVX512(boundaryAVX512(side, delta, _mm512_sub_epi32(_mm512_add_epi32(taken, count), oneInt)), limit, countX));
+            while (fewer) {
+                count = _mm512_mask_sub_epi32(count, fewer, count, oneInt);
+                fewer = (__mmask16)(fewer & _mm512_cmpgt_epi32_mask(count, zeroInt) & ~beforeLimitAVX512(boundaryAVX512(side, delta, _mm512_sub_epi32(_mm512_add_epi32(taken, count), oneInt)), limit, countX));
+            }
+            __mmask16 more = (__mmask16)(pending & _mm512_cmpgt_epi32_mask(cap, count) & beforeLimitAVX512(boundaryAVX512(side, delta, _mm512_add_epi32(taken, count)), limit, countX));
+            while (more) {
+                count = _mm512_mask_add_epi32(count, more, count, oneInt);
+                more = (__mmask16)(more & _mm512_cmpgt_epi32_mask(cap, count) & beforeLimitAVX512(boundaryAVX512(side, delta, _mm512_add_epi32(taken, count)), limit, countX));
+            }
+            __m512i crossedX = _mm512_mask_blend_epi32(leaveX, count, extentX), crossedY = _mm512_mask_blend_epi32(leaveX, extentY, count);
+            __m512i crossed = _mm512_add_epi32(crossedX, crossedY);
+            jumped = (__mmask16)(pending & _mm512_cmpgt_epi32_mask(crossed, zeroInt));
+            crossedX = _mm512_maskz_mov_epi32(jumped, crossedX);
+            crossedY = _mm512_maskz_mov_epi32(jumped, crossedY);
+
+            __m512 lastX = boundaryAVX512(sideX, deltaX, _mm512_sub_epi32(_mm512_add_epi32(stepsX, crossedX), oneInt));
+            __m512 lastY = boundaryAVX512(sideY, deltaY, _mm512_sub_epi32(_mm512_add_epi32(stepsY, crossedY), oneInt));
+            __mmask16 lastAlongX = (__mmask16)(_mm512_cmpeq_epi32_mask(crossedY, zeroInt) | _mm512_cmp_ps_mask(lastX, lastY, _CMP_GE_OQ));
+            __mmask16 fromX = (__mmask16)(_mm512_cmpgt_epi32_mask(crossedX, zeroInt) & lastAlongX);
+            distance = _mm512_mask_mov_ps(distance, jumped, _mm512_mask_blend_ps(fromX, lastY, lastX));
+            hitFromX = (__mmask16)((hitFromX & ~jumped) | (fromX & jumped));
+            stepsX = _mm512_add_epi32(stepsX, crossedX);
+            stepsY = _mm512_add_epi32(stepsY, crossedY);
+            cellX = _mm512_add_epi32(cellX, _mm512_mullo_epi32(crossedX, stepX));
+            cellY = _mm512_add_epi32(cellY, _mm512_mullo_epi32(crossedY, stepY));
+            cells = _mm512_mask_add_epi32(cells, jumped, cells, crossed);
+            moves = _mm512_mask_add_epi32(moves, jumped, moves, oneInt);
+            nextX = _mm512_mask_mov_ps(nextX, jumped, boundaryAVX512(sideX, deltaX, stepsX));
+            nextY = _mm512_mask_mov_ps(nextY, jumped, boundaryAVX512(sideY, deltaY, stepsY));
+            pending = 0;
+        }
+
+        __mmask16 step = (__mmask16)(active & ~jumped);
+        if (!step) continue;
+        __mmask16 closerX = _mm512_cmp_ps_mask(nextX, nextY, _CMP_LT_OQ);
+        __mmask16 moveX = closerX & step, moveY = (__mmask16)(~closerX & step);
+
+        distance = _mm512_mask_blend_ps(moveX, distance, nextX);
+        distance = _mm512_mask_blend_ps(moveY, distance, nextY);
+        nextX = _mm512_mask_mov_ps(nextX, moveX, afterX);
+        nextY = _mm512_mask_mov_ps(nextY, moveY, afterY);
+        stepsX = _mm512_mask_add_epi32(stepsX, moveX, stepsX, oneInt);
+        stepsY = _mm512_mask_add_epi32(stepsY, moveY, stepsY, oneInt);
+        cellX = _mm512_mask_add_epi32(cellX, moveX, cellX, stepX);
+        cellY = _mm512_mask_add_epi32(cellY, moveY, cellY, stepY);
+        hitFromX = (__mmask16)((hitFromX & ~step) | moveX);
+        cells = _mm512_mask_add_epi32(cells, step, cells, oneInt);
+        moves = _mm512_mask_add_epi32(moves, step, moves, oneInt);
+
+        __m512i aheadX = _mm512_sub_epi32(stepsX, lookedUpX), aheadY = _mm512_sub_epi32(stepsY, lookedUpY);
+        __mmask16 inRow = (__mmask16)(_mm512_cmpeq_epi32_mask(aheadY, zeroInt) & _mm512_cmple_epi32_mask(aheadX, runX));
+        __mmask16 inColumn = (__mmask16)(_mm512_cmpeq_epi32_mask(aheadX, zeroInt) & _mm512_cmple_epi32_mask(aheadY, runY));
+        __mmask16 inSquare = (__mmask16)(_mm512_cmple_epi32_mask(aheadX, radius) & _mm512_cmple_epi32_mask(aheadY, radius));
+        __mmask16 lookup = (__mmask16)(step & ~(inRow | inColumn | inSquare));
+        if (!lookup) continue;
+        steps = _mm512_mask_add_epi32(steps, lookup, steps, oneInt);
+
+        __m512i cell = _mm512_add_epi32(_mm512_mullo_epi32(cellY, width), cellX);
+        // Zero masked shifts, the unmasked ones trip a false uninitialized warning in GCC's headers.
+        __m512i solidWordsOfCells = _mm512_mask_i32gather_epi32(zeroInt, lookup, _mm512_maskz_srli_epi32(lookup, cell, 5), solidWords, 4);
+        __m512i solid = _mm512_and_si512(_mm512_maskz_srlv_epi32(lookup, solidWordsOfCells, _mm512_and_si512(cell, _mm512_set1_epi32(31))), oneInt);
+        __mmask16 wall = (__mmask16)(lookup & _mm512_cmpeq_epi32_mask(solid, oneInt));
+        active = (__mmask16)(active & ~wall);
+
+        __mmask16 load = (__mmask16)(lookup & ~wall);
+        if (skipEmpty && load) {
+            alignas(64) int xs[16], ys[16], loaded[16] = {};
+            _mm512_store_si512(xs, cellX);
+            _mm512_store_si512(ys, cellY);
+            for (unsigned lanes = load; lanes != 0; lanes &= lanes - 1) {
+                int i = __builtin_ctz(lanes);
+                loaded[i] = map.getWallDistances(xs[i], ys[i]);
+            }
+            __m512i words = _mm512_load_si512(loaded);
+            runX = _mm512_mask_and_epi32(runX, load, _mm512_maskz_srlv_epi32(load, words, shiftX), runMask);
+            runY = _mm512_mask_and_epi32(runY, load, _mm512_maskz_srlv_epi32(load, words, shiftY), runMask);
+            radius = _mm512_mask_srli_epi32(radius, load, words, WallDistances::radius);
+            lookedUpX = _mm512_mask_mov_epi32(lookedUpX, load, stepsX);
+            lookedUpY = _mm512_mask_mov_epi32(lookedUpY, load, stepsY);
+            pending = (__mmask16)(load & ~_mm512_cmpgt_epi32_mask(minJump, radius));
+        }
+    }
+
+    // Explicitly rounded like boundaryAVX512.
+    __m512 x = _mm512_maskz_add_round_ps(allLanes, originX, _mm512_maskz_mul_round_ps(allLanes, dirX, distance, _MM_FROUND_CUR_DIRECTION), _MM_FROUND_CUR_DIRECTION);
+    __m512 y = _mm512_maskz_add_round_ps(allLanes, originY, _mm512_maskz_mul_round_ps(allLanes, dirY, distance, _MM_FROUND_CUR_DIRECTION), _MM_FROUND_CUR_DIRECTION);
+
+    __m512 alongX = _mm512_sub_ps(y, _mm512_floor_ps(y));
+    alongX = _mm512_mask_sub_ps(alongX, _mm512_cmp_ps_mask(dirX, zero, _CMP_GT_OQ), one, alongX);
+    __m512 alongY = _mm512_sub_ps(x, _mm512_floor_ps(x));
+    alongY = _mm512_mask_sub_ps(alongY, negativeY, one, alongY);
+    __m512 textureX = _mm512_mask_blend_ps(hitFromX, alongY, alongX);
+
+    alignas(64) float xs[16], ys[16], distances[16], textureXs[16];
+    alignas(64) int cellXs[16], cellYs[16], stepCounts[16], cellCounts[16], moveCounts[16];
+    _mm512_store_ps(xs, x);
+    _mm512_store_ps(ys, y);
+    _mm512_store_ps(distances, distance);
+    _mm512_store_ps(textureXs, textureX);
+    _mm512_store_si512(cellXs, cellX);
+    _mm512_store_si512(cellYs, cellY);
+    _mm512_store_si512(stepCounts, steps);
+    _mm512_store_si512(cellCounts, cells);
+    _mm512_store_si512(moveCounts, moves);
+
+    for (size_t i = 0; i < packet.count; i++) {
+        hits[i] = {xs[i], ys[i], distances[i], textureXs[i], cellXs[i], cellYs[i], (hitFromX >> i & 1) != 0, (unsigned int)stepCounts[i], (unsigned int)cellCounts[i], (unsigned int)moveCounts[i]};
+    }
+}
+
+#else
+
+void PacketCaster::castDDAAVX2(const RayPacket &, const PacketStart &, size_t, const Map &, bool, RayHit *) {
+    throw std::logic_error("AVX2 is not available on this platform");
+}
+
+void PacketCaster::castDDAAVX512(const RayPacket &, const PacketStart &, const Map &, bool, RayHit *) {
+    throw std::logic_error("AVX-512 is not available on this platform");
+}
+
+#endif
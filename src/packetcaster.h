@@ -0,0 +1,96 @@
+#ifndef packetcasterH
+#define packetcasterH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "map.h"
+
+// Result of casting a single ray through the map.
+struct RayHit {
+    float x, y;         // Point where the ray hit a wall.
+    float distance;     // Distance travelled along the ray (not fisheye corrected).
+    float textureX;     // Horizontal position on the hit wall face in range [0, 1].
+    int cellX, cellY;   // Map cell that was hit.
+    bool hitFromX;      // True when the ray crossed an x boundary to hit the wall.
+    unsigned int steps; // Number of map lookups performed.
+    unsigned int cells; // Number of cells entered, more than steps when known empty cells were not looked up.
+    unsigned int moves; // Number of DDA iterations, fewer than cells when the empty space around cells was crossed in jumps.
+};
+
+// Rays of adjacent screen columns, all starting from the camera.
+struct RayPacket {
+    static constexpr size_t maxRays = 16;
+
+    float originX, originY;
+    alignas(64) std::array<float, maxRays> dirX, dirY; // Normalised directions.
+    size_t count;
+};
+
+// Starting state of a DDA traversal.
+struct RayStart {
+    float deltaX, deltaY; // Ray length needed to cross a whole cell along each axis.
+    float sideX, sideY;   // Ray length to the first x and y cell boundaries.
+};
+
+// Instruction set used for casting rays.
+enum class RayCastingIsa {
+    Scalar, // One ray at a time, works everywhere.
+    AVX2,   // 8 rays per instruction.
+    AVX512  // 16 rays per instruction.
+};
+
+// DDA traversal of whole ray packets with SIMD instructions, chosen at runtime.
+// Every ray starts from startRay, which Renderer::castRayDDA uses as well, places the n-th boundary of an axis at
+// side + n * delta instead of adding delta up, and computes the hit point the way the scalar code does, so hits are
+// bit identical whatever the instruction set and however many cells a ray crosses at once.
+class PacketCaster {
+    // Per lane starting states of one packet.
+    struct PacketStart {
+        alignas(64) std::array<float, RayPacket::maxRays> deltaX, deltaY, sideX, sideY;
+    };
+
+public:
+    // Fastest instruction set the CPU supports.
+    static RayCastingIsa getBestIsa();
+
+    static bool isSupported(RayCastingIsa isa);
+
+    static const char *getName(RayCastingIsa isa);
+
+    // Packets read the occupancy bits of flat maps directly, chunked maps have to be cast one ray at a time.
+    static bool canCast(const Map &map);
+
+    // Rays only jump across the empty square around a cell of at least this radius. A jump has to wait for the lookup
+    // before it, while stepping runs ahead of its branches, so narrower squares are quicker to step through.
+    static constexpr int minJumpRadius = 4;
+
+    // Compiled once and never inlined into vector code, so fast math cannot set rays up differently per caller.
+    static RayStart startRay(float originX, float originY, float dirX, float dirY);
+
+    // Boundaries of one axis from boundary taken on, the n-th at side + n * delta, that come before limit, or at it as
+    // well when touching, counting at most cap of them. Boundaries only grow with n, so the count is estimated with
+    // inverse, 1 / delta, and then corrected by comparing the boundaries on both sides of it.
+    static int countBoundaries(float side, float delta, float inverse, int taken, int cap, float limit, bool touching) {
+        auto before = [&](int n) {
+            float at = side + (float)n * delta;
+            return touching ? at <= limit : at < limit;
+        };
+        // Truncating plus one rounds up, except at whole numbers, where the loops correct it.
+        int count = (int)std::clamp((limit - side) * inverse + 1.f - (float)taken, 0.f, (float)cap);
+        while (count > 0 && !before(taken + count - 1)) count--;
+        while (count < cap && before(taken + count)) count++;
+        return count;
+    }
+
+    // Cast every ray of packet with isa, which must be supported and not Scalar. skipEmpty enters and jumps across
+    // the empty space Map::getWallDistances shows around cells the way Renderer::castRayDDA does.
+    static void castDDA(RayCastingIsa isa, const RayPacket &packet, const Map &map, std::array<RayHit, RayPacket::maxRays> &hits, bool skipEmpty = true);
+
+private:
+    static void castDDAAVX2(const RayPacket &packet, const PacketStart &start, size_t first, const Map &map, bool skipEmpty, RayHit *hits);
+    static void castDDAAVX512(const RayPacket &packet, const PacketStart &start, const Map &map, bool skipEmpty, RayHit *hits);
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef pixelH
+#define pixelH
+
+#include <bit>
+#include <cstdint>
+#include <SFML/Graphics.hpp>
+
+// Color packed into 32 bits so its bytes in memory are r, g, b, a, the layout sf::Texture::update expects.
+using Pixel = uint32_t;
+
+inline Pixel toPixel(const sf::Color &color) {
+    if constexpr (std::endian::native == std::endian::little)
+        return (Pixel)color.r | (Pixel)color.g << 8 | (Pixel)color.b << 16 | (Pixel)color.a << 24;
+    else
+        return (Pixel)color.r << 24 | (Pixel)color.g << 16 | (Pixel)color.b << 8 | (Pixel)color.a;
+}
+
+inline sf::Color toColor(Pixel pixel) {
+    if constexpr (std::endian::native == std::endian::little)
+        return sf::Color((sf::Uint8)pixel, (sf::Uint8)(pixel >> 8), (sf::Uint8)(pixel >> 16), (sf::Uint8)(pixel >> 24));
+    else
+        return sf::Color((sf::Uint8)(pixel >> 24), (sf::Uint8)(pixel >> 16), (sf::Uint8)(pixel >> 8), (sf::Uint8)pixel);
+}
+
+#endif
@@ -11,11 +11,11 @@ Player::Player() {
     angle = 0.f;
 }
 
-float Player::getX() { return x; }
+float Player::getX() const { return x; }
 void Player::setX(float newX) { x = newX; }
-float Player::getY() { return y; }
+float Player::getY() const { return y; }
 void Player::setY(float newY) { y = newY; }
-float Player::getAngle() { return angle; }
+float Player::getAngle() const { return angle; }
 
 Player::Player(float start_x, float start_y, float start_angle) {
     x = start_x;
@@ -24,7 +24,7 @@ Player::Player(float start_x, float start_y, float start_angle) {
 }
 
 // move forward and right relative to current position and angle
-void Player::moveRelative(float forwardDistance, float rightDistance, const std::vector<std::vector<int>> &map) {
+void Player::moveRelative(float forwardDistance, float rightDistance, const Map &map) {
     float new_x = x, new_y = y;
     new_x += forwardDistance * sinf(degreesToRadians(angle));
     new_y += forwardDistance * cosf(degreesToRadians(angle));
@@ -32,34 +32,43 @@ void Player::moveRelative(float forwardDistance, float rightDistance, const std:
     new_y += rightDistance * cosf(degreesToRadians(angle + 90));
 
     // Check for collision.
-    if (!map[(int)new_y][(int)new_x]) {
+    if (!map.isSolid((int)new_x, (int)new_y)) {
         x = new_x;
         y = new_y;
-    } else if (!map[(int)y][(int)new_x]) { // Slide on walls instead of stopping
+    } else if (!map.isSolid((int)new_x, (int)y)) { // Slide on walls instead of stopping
         x = new_x;
-    } else if (!map[(int)new_y][(int)x]) {
+    } else if (!map.isSolid((int)x, (int)new_y)) {
         y = new_y;
     }
 }
 
-void Player::movement(float deltaTime, const std::vector<std::vector<int>> &map) {
-    // std::cout << angle << " " << x << " " << y << "\n";
-    // DeltaTime ensures similar real time player speed between different framerates.
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) {
+PlayerInput Player::readInput() {
+    PlayerInput input;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) input.keys |= PlayerInput::Forward;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) input.keys |= PlayerInput::Backward;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) input.keys |= PlayerInput::Left;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) input.keys |= PlayerInput::Right;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt)) input.keys |= PlayerInput::Strafe;
+    return input;
+}
+
+void Player::movement(const PlayerInput &input, float deltaTime, const Map &map) {
+    // DeltaTime ensures similar real time player speed between different tick rates.
+    if (input.isHeld(PlayerInput::Forward)) {
         moveRelative(speed * deltaTime, 0, map);
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) {
+    if (input.isHeld(PlayerInput::Backward)) {
         moveRelative(-speed * deltaTime, 0, map);
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt)) {
+    if (input.isHeld(PlayerInput::Left)) {
+        if (input.isHeld(PlayerInput::Strafe)) {
             moveRelative(0, -horizontalSpeed * deltaTime, map);
         } else {
             angle -= angularSpeed * deltaTime;
         }
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt)) {
+    if (input.isHeld(PlayerInput::Right)) {
+        if (input.isHeld(PlayerInput::Strafe)) {
             moveRelative(0, horizontalSpeed * deltaTime, map);
         } else {
             angle += angularSpeed * deltaTime;
@@ -72,6 +81,17 @@ void Player::movement(float deltaTime, const std::vector<std::vector<int>> &map)
         angle += 360;
 }
 
+Player Player::interpolate(const Player &previous, const Player &next, float t) {
+    float turn = next.getAngle() - previous.getAngle();
+    if (turn > 180) turn -= 360;
+    if (turn < -180) turn += 360;
+
+    float angle = previous.getAngle() + turn * t;
+    if (angle < 0) angle += 360;
+    if (angle > 360) angle -= 360;
+    return Player(previous.getX() + (next.getX() - previous.getX()) * t, previous.getY() + (next.getY() - previous.getY()) * t, angle);
+}
+
 float Player::degreesToRadians(float degrees) {
     return degrees * (float)M_PI / 180.f;
 }
@@ -1,7 +1,22 @@
 #ifndef playerH
 #define playerH
 
-#include <vector>
+#include "map.h"
+
+// Movement keys held down, read once per frame and applied by every simulation tick of it.
+struct PlayerInput {
+    enum Key : unsigned int {
+        Forward = 1,
+        Backward = 2,
+        Left = 4,
+        Right = 8,
+        Strafe = 16 // Left and Right move sideways instead of turning.
+    };
+
+    unsigned int keys = 0;
+
+    bool isHeld(Key key) const { return (keys & key) != 0; }
+};
 
 // Class representing a player and his movement.
 class Player {
@@ -10,21 +25,28 @@ class Player {
 public:
     Player();
 
-    float getX();
+    float getX() const;
     void setX(float newX);
-    float getY();
+    float getY() const;
     void setY(float newY);
-    float getAngle();
+    float getAngle() const;
 
     Player(float start_x, float start_y, float start_angle);
 
 private:
     // move forward and right relative to current position and angle
-    void moveRelative(float forwardDistance, float rightDistance, const std::vector<std::vector<int>> &map);
+    void moveRelative(float forwardDistance, float rightDistance, const Map &map);
     float degreesToRadians(float degrees);
 
 public:
-    void movement(float deltaTime, const std::vector<std::vector<int>> &map);
+    // Read the movement keys from the keyboard.
+    static PlayerInput readInput();
+
+    // Advance the player by deltaTime milliseconds of input.
+    void movement(const PlayerInput &input, float deltaTime, const Map &map);
+
+    // Position and angle a fraction t of the way from previous to next, turning the short way round.
+    static Player interpolate(const Player &previous, const Player &next, float t);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "profiler.h"
+
+#ifdef PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+std::mutex Profiler::mutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::buffers;
+std::vector<Profiler::ThreadBuffer *> Profiler::freeBuffers;
+std::map<std::string, std::deque<double>> Profiler::history;
+
+uint64_t Profiler::now() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+Profiler::BufferOwner::~BufferOwner() {
+    if (pBuffer == nullptr) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBuffers.push_back(pBuffer);
+}
+
+// Short lived threads, like the one prefetching each level, take over buffers of exited ones,
+// so the number of buffers follows the most threads alive at once.
+Profiler::ThreadBuffer &Profiler::getThreadBuffer() {
+    thread_local BufferOwner owner;
+    if (owner.pBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeBuffers.empty()) {
+            buffers.push_back(std::make_unique<ThreadBuffer>());
+            owner.pBuffer = buffers.back().get();
+            owner.pBuffer->events = std::make_unique<EventSlot[]>(bufferCapacity);
+            owner.pBuffer->thread = (unsigned int)buffers.size();
+        } else {
+            owner.pBuffer = freeBuffers.back();
+            freeBuffers.pop_back();
+        }
+    }
+    return *owner.pBuffer;
+}
+
+void Profiler::record(const char *name, uint64_t start, uint64_t end) {
+    ThreadBuffer &buffer = getThreadBuffer();
+    size_t written = buffer.written.load(std::memory_order_relaxed);
+    EventSlot &slot = buffer.events[written % bufferCapacity];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(end - start, std::memory_order_relaxed);
+    buffer.written.store(written + 1, std::memory_order_release);
+}
+
+// Copied first and checked after: slots the writer may have reached while they were copied, including
+// the one it may be writing now, are dropped.
+std::vector<ProfileEvent> Profiler::readEvents(const ThreadBuffer &buffer, size_t first, size_t last) {
+    first = std::max(first, last - std::min(last, bufferCapacity));
+    std::vector<ProfileEvent> events;
+    events.reserve(last - first);
+    for (size_t i = first; i < last; i++) {
+        const EventSlot &slot = buffer.events[i % bufferCapacity];
+        events.push_back({slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed), slot.duration.load(std::memory_order_relaxed)});
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t overwritten = buffer.written.load(std::memory_order_relaxed) + 1;
+    overwritten -= std::min(overwritten, bufferCapacity);
+    if (overwritten > first) events.erase(events.begin(), events.begin() + (ptrdiff_t)std::min(overwritten - first, events.size()));
+    return events;
+}
+
+void Profiler::endFrame() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Sum the stages over all threads, so parallel stages report their total cpu time.
+    std::map<std::string, double> frame;
+    for (std::unique_ptr<ThreadBuffer> &buffer : buffers) {
+        // Events overwritten before being consumed are lost.
+        size_t written = buffer->written.load(std::memory_order_acquire);
+        for (const ProfileEvent &event : readEvents(*buffer, buffer->consumed, written)) {
+            frame[event.name] += (double)event.duration / 1e6;
+        }
+        buffer->consumed = written;
+    }
+
+    for (const auto &[name, time] : frame)
+        history[name];
+    for (auto &[name, times] : history) {
+        auto it = frame.find(name);
+        times.push_back(it == frame.end() ? 0.0 : it->second);
+        if (times.size() > historyLength) times.pop_front();
+    }
+}
+
+std::vector<StageStats> Profiler::getStageStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<StageStats> stats;
+    for (const auto &[name, times] : history) {
+        std::vector<double> sorted(times.begin(), times.end());
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double time : sorted)
+            total += time;
+        stats.push_back({name, total / (double)sorted.size(), sorted[sorted.size() / 2], sorted[(sorted.size() - 1) * 99 / 100]});
+    }
+    return stats;
+}
+
+bool Profiler::writeChromeTrace(const std::string &filePath) {
+    std::ofstream file(filePath);
+    if (!file) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    bool first = true;
+    for (std::unique_ptr<ThreadBuffer> &buffer : buffers) {
+        for (const ProfileEvent &event : readEvents(*buffer, 0, buffer->written.load(std::memory_order_acquire))) {
+            // Complete events, timestamps in microseconds.
+            file << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread
+                 << ",\"ts\":" << (double)event.start / 1e3 << ",\"dur\":" << (double)event.duration / 1e3 << "}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return (bool)file;
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef profilerH
+#define profilerH
+
+// Frame stage instrumentation, compiled in only when PROFILING is defined (make PROFILING=1).
+// Without it PROFILE_SCOPE expands to nothing and no profiler code is built.
+
+#ifdef PROFILING
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One timed section, times in nanoseconds since the profiler started.
+struct ProfileEvent {
+    const char *name;
+    uint64_t start, duration;
+};
+
+// Rolling statistics of one stage, in milliseconds per frame.
+struct StageStats {
+    std::string name;
+    double mean, p50, p99;
+};
+
+// Collects timed sections from any thread into per thread ring buffers.
+class Profiler {
+    // ProfileEvent in atomics, so a slot may be read while its thread overwrites it.
+    struct EventSlot {
+        std::atomic<const char *> name;
+        std::atomic<uint64_t> start, duration;
+    };
+
+    // Events of one thread, the oldest ones are overwritten when it is full. Only the owning thread writes,
+    // and it publishes each event by advancing written, so recording takes no lock.
+    // Buffers of threads that exited are reused by new ones, which then share their track in traces.
+    struct ThreadBuffer {
+        std::unique_ptr<EventSlot[]> events;
+        std::atomic<size_t> written = 0;
+        size_t consumed = 0; // Guarded by mutex.
+        unsigned int thread;
+    };
+
+    // Hands its thread's buffer back to freeBuffers when the thread exits.
+    struct BufferOwner {
+        ThreadBuffer *pBuffer = nullptr;
+        ~BufferOwner();
+    };
+
+    static constexpr size_t bufferCapacity = 1 << 16;
+    static constexpr size_t historyLength = 120; // Frames in rolling statistics.
+
+    static std::mutex mutex; // Guards everything below.
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    static std::vector<ThreadBuffer *> freeBuffers;
+    static std::map<std::string, std::deque<double>> history;
+
+public:
+    // Nanoseconds since the profiler started.
+    static uint64_t now();
+
+    static void record(const char *name, uint64_t start, uint64_t end);
+
+    // Add the time spent in each stage since the last call to the rolling statistics.
+    static void endFrame();
+
+    // Mean, median and 99th percentile of every stage over the last frames.
+    static std::vector<StageStats> getStageStats();
+
+    // Write all buffered events in Chrome trace event format, viewable in chrome://tracing or Perfetto.
+    static bool writeChromeTrace(const std::string &filePath);
+
+private:
+    static ThreadBuffer &getThreadBuffer();
+
+    // Events of buffer from index first up to last, which the thread has published, that are still intact.
+    static std::vector<ProfileEvent> readEvents(const ThreadBuffer &buffer, size_t first, size_t last);
+};
+
+// Times the enclosing scope.
+class ProfileScope {
+    const char *name;
+    uint64_t start;
+
+public:
+    ProfileScope(const char *scopeName) : name(scopeName), start(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(name, start, Profiler::now()); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+#endif
+
+#endif
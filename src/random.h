@@ -0,0 +1,44 @@
+#ifndef randomH
+#define randomH
+
+#include <cstdint>
+
+// Small, fast and seedable pseudo random generator (xoshiro256**).
+// The same seed always produces the same sequence on every platform.
+class Random {
+    uint64_t state[4];
+
+    static uint64_t rotateLeft(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+public:
+    Random(uint64_t seed) {
+        // Expand the seed with splitmix64, so similar seeds give unrelated states.
+        for (uint64_t &word : state) {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t shifted = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= shifted;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+    // Random int in range (inclusive), without rejection loops.
+    int inRange(int start, int end) {
+        uint64_t range = (uint64_t)((int64_t)end - start + 1);
+        return start + (int)(((next() >> 32) * range) >> 32);
+    }
+};
+
+#endif
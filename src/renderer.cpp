@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "renderer.h"
+#include "profiler.h"
+
+Renderer::Renderer(unsigned int renderThreads) {
+    pRenderPool = new ThreadPool(renderThreads);
+}
+
+void Renderer::setRayCastingMode(RayCastingMode mode) {
+    rayCastingMode = mode;
+}
+
+void Renderer::setRayCastingIsa(RayCastingIsa isa) {
+    if (!PacketCaster::isSupported(isa))
+        throw std::invalid_argument(std::string("CPU does not support ") + PacketCaster::getName(isa));
+    rayCastingIsa = isa;
+}
+
+RayCastingIsa Renderer::getRayCastingIsa() { return rayCastingIsa; }
+
+void Renderer::setEmptySkipping(bool skipping) { emptySkipping = skipping; }
+
+void Renderer::setPlaneCasting(bool casting) { planeCasting = casting; }
+
+void Renderer::setMipmapping(bool enabled) { mipmapping = enabled; }
+
+unsigned int Renderer::getThreadCount() { return pRenderPool->getThreadCount(); }
+
+unsigned long long Renderer::getRaySteps() { return raySteps.load(); }
+
+unsigned long long Renderer::getRayCells() { return rayCells.load(); }
+
+size_t Renderer::getVisibleSprites() { return projectedSprites.size(); }
+
+const std::vector<float> &Renderer::getDepthBuffer() const { return depthBuffer; }
+
+void Renderer::renderFrame(FrameBuffer &frameBuffer, const Map &map, const Texture &sky, float cameraX, float cameraY, float cameraAngle, const SpriteLayer *pSprites) {
+    // For each pixel in screen width cast a ray to a corresponding angle in fov range and extend
+    // until it hits a wall, then calculate necessary wall height.
+    // Columns are independent, so tiles of them are rendered in parallel.
+    // Textured floor and ceiling are then drawn a row at a time around the walls, with rows in parallel,
+    // and last sprites over both, depth tested against the walls column by column.
+    raySteps = 0;
+    rayCells = 0;
+    updateColumnAngles(frameBuffer.getLength());
+    std::optional<uint32_t> floorRegion = planeCasting ? map.getFloorRegion() : std::nullopt;
+    std::optional<uint32_t> ceilingRegion = planeCasting ? map.getCeilingRegion() : std::nullopt;
+    pRenderPool->parallelFor(frameBuffer.getLength(), renderTileSize, [&](size_t begin, size_t end) {
+        std::array<WallColumn, renderTileSize> columns;
+        unsigned long long tileSteps = 0, tileCells = 0;
+        {
+            PROFILE_SCOPE("ray casting");
+            castTile(frameBuffer, map, begin, end, cameraX, cameraY, cameraAngle, columns.data());
+            for (size_t x = begin; x < end; x++) {
+                tileSteps += columns[x - begin].hit.steps;
+                tileCells += columns[x - begin].hit.cells;
+            }
+        }
+        {
+            PROFILE_SCOPE("columns");
+            drawColumns(frameBuffer, map.getAtlas(), sky, begin, end, columns.data(), floorRegion.has_value(), ceilingRegion.has_value());
+        }
+        raySteps += tileSteps;
+        rayCells += tileCells;
+    });
+
+    if (floorRegion || ceilingRegion) {
+        pRenderPool->parallelFor(frameBuffer.getHeight(), planeTileSize, [&](size_t begin, size_t end) {
+            PROFILE_SCOPE("floor and ceiling");
+            drawPlaneRows(frameBuffer, map.getAtlas(), floorRegion, ceilingRegion, begin, end, cameraX, cameraY, cameraAngle);
+        });
+    }
+
+    projectedSprites.clear();
+    if (!pSprites || pSprites->size() == 0) return;
+    {
+        PROFILE_SCOPE("sprite culling");
+        projectSprites(frameBuffer, *pSprites, cameraX, cameraY, cameraAngle);
+    }
+    if (projectedSprites.empty()) return;
+    pRenderPool->parallelFor(frameBuffer.getLength(), renderTileSize, [&](size_t begin, size_t end) {
+        PROFILE_SCOPE("sprites");
+        drawSprites(frameBuffer, *pSprites, begin, end);
+    });
+}
+
+void Renderer::castColumns(const FrameBuffer &frameBuffer, const Map &map, float cameraX, float cameraY, float cameraAngle, std::vector<WallColumn> &columns) {
+    columns.resize(frameBuffer.getLength());
+    updateColumnAngles(frameBuffer.getLength());
+    for (size_t begin = 0; begin < columns.size(); begin += renderTileSize) {
+        castTile(frameBuffer, map, begin, std::min(begin + renderTileSize, columns.size()), cameraX, cameraY, cameraAngle, &columns[begin]);
+    }
+}
+
+void Renderer::updateColumnAngles(size_t length) {
+    if (columnSin.size() == length) return;
+    columnSin.resize(length);
+    columnCos.resize(length);
+    columnTan.resize(length);
+    floorLimits.resize(length);
+    ceilingLimits.resize(length);
+    depthBuffer.resize(length);
+    tileSprites.resize((length + renderTileSize - 1) / renderTileSize);
+    for (size_t x = 0; x < length; x++) {
+        float offset = -(float)fov / 2.f + (float)fov * (float)x / (float)length;
+        columnSin[x] = sinf(degreesToRadians(offset));
+        columnCos[x] = cosf(degreesToRadians(offset));
+        columnTan[x] = columnSin[x] / columnCos[x];
+    }
+}
+
+void Renderer::castTile(const FrameBuffer &frameBuffer, const Map &map, size_t begin, size_t end, float playerX, float playerY, float playerAngle, WallColumn *columns) {
+    static_assert(renderTileSize <= RayPacket::maxRays);
+    float halfHeight = (float)frameBuffer.getHeight() / 2.f;
+
+    // Directions are set up the same way for both paths, so packets see exactly the rays scalar casting would.
+    RayPacket packet{};
+    packet.originX = playerX;
+    packet.originY = playerY;
+    packet.count = end - begin;
+    float cameraSin = sinf(degreesToRadians(playerAngle)), cameraCos = cosf(degreesToRadians(playerAngle));
+    for (size_t i = 0; i < packet.count; i++) {
+        // Rays range from playerAngle - (fov / 2) to playerAngle + (fov / 2)
+        float rayAngle = playerAngle - (float)fov / 2.f + (float)fov * (float)(begin + i) / (float)frameBuffer.getLength();
+
+        // Normalise rayAngle.
+        while (rayAngle > 360)
+            rayAngle -= 360;
+        while (rayAngle < 0)
+            rayAngle += 360;
+        columns[i].rayAngle = rayAngle;
+
+        // 0 degrees is positive y, 90 degrees positive x
+        // so the angle to x if 90 - playerAngle, which flips sin and cos.
+        // The camera direction is rotated by the column offset instead of calling sinf and cosf per ray.
+        packet.dirX[i] = cameraSin * columnCos[begin + i] + cameraCos * columnSin[begin + i];
+        packet.dirY[i] = cameraCos * columnCos[begin + i] - cameraSin * columnSin[begin + i];
+    }
+
+    if (rayCastingMode == RayCastingMode::DDA && rayCastingIsa != RayCastingIsa::Scalar && PacketCaster::canCast(map)) {
+        std::array<RayHit, RayPacket::maxRays> hits;
+        PacketCaster::castDDA(rayCastingIsa, packet, map, hits, emptySkipping);
+        for (size_t i = 0; i < packet.count; i++) {
+            columns[i].hit = hits[i];
+        }
+    } else {
+        for (size_t i = 0; i < packet.count; i++) {
+            columns[i].hit = castRay(playerX, playerY, packet.dirX[i], packet.dirY[i], map);
+        }
+    }
+
+    for (size_t i = 0; i < packet.count; i++) {
+        WallColumn &column = columns[i];
+
+        // Fisheye fix, normalise to playerAngle vector
+        float distanceToWall = column.hit.distance * columnCos[begin + i];
+
+        column.wallHeight = halfHeight / distanceToWall;
+        depthBuffer[begin + i] = distanceToWall;
+
+        // Load wall texture
+        column.textureRegion = map.getTextureRegion(column.hit.cellX, column.hit.cellY);
+
+        // Texels per screen pixel down the wall halve with every mip level, stop at the last level
+        // that still has at least one. Distant walls then read a few small, cache resident columns.
+        const AtlasRegion &region = map.getAtlas().getRegion(column.textureRegion);
+        column.textureLevel = 0;
+        if (mipmapping) {
+            float texelsPerPixel = (float)region.height / (2.f * column.wallHeight);
+            while (texelsPerPixel >= 2.f && column.textureLevel + 1 < region.levelCount) {
+                texelsPerPixel /= 2.f;
+                column.textureLevel++;
+            }
+        }
+
+        // Calculate which vertical strip of the texture to use
+        int textureWidth = (int)region.getLevelWidth(column.textureLevel);
+        column.textureColumn = std::min((int)(column.hit.textureX * (float)textureWidth), textureWidth - 1);
+    }
+}
+
+void Renderer::drawColumns(FrameBuffer &frameBuffer, const TextureAtlas &atlas, const Texture &sky, size_t begin, size_t end, const WallColumn *columns, bool castFloor, bool castCeiling) {
+    std::array<ColumnSpans, renderTileSize> spans;
+    int horizon = frameBuffer.getHorizonRow();
+    for (size_t i = 0; i < end - begin; i++) {
+        const WallColumn &column = columns[i];
+        size_t skyVerticalSlipIdx = sky.wrapColumn((size_t)((float)sky.getWidth() * (column.rayAngle / 360.f)));
+        spans[i] = {column.wallHeight, atlas.getColumn(column.textureRegion, column.textureLevel, (size_t)column.textureColumn), {}};
+        if (!castCeiling) spans[i].skyTexels = sky.getColumn(skyVerticalSlipIdx);
+
+        WallRows rows = frameBuffer.getWallRows(column.wallHeight);
+        floorLimits[begin + i] = std::min(rows.first, horizon) - 1;
+        ceilingLimits[begin + i] = std::max(rows.last + 1, horizon);
+    }
+    frameBuffer.drawColumns(begin, spans.data(), end - begin, castFloor ? nullptr : &floorPixel);
+}
+
+// A row y pixels from the middle of the screen shows the floor, or ceiling, where it is as far away as a wall
+// y pixels high, so the same distance scale keeps walls standing on the floor.
+void Renderer::drawPlaneRows(FrameBuffer &frameBuffer, const TextureAtlas &atlas, std::optional<uint32_t> floorRegion, std::optional<uint32_t> ceilingRegion, size_t begin, size_t end, float cameraX, float cameraY, float cameraAngle) {
+    float halfHeight = (float)frameBuffer.getHeight() / 2.f, wallCenter = (float)(frameBuffer.getHeight() / 2);
+    int horizon = frameBuffer.getHorizonRow();
+    float cameraSin = sinf(degreesToRadians(cameraAngle)), cameraCos = cosf(degreesToRadians(cameraAngle));
+
+    for (size_t y = begin; y < end; y++) {
+        bool floor = (int)y < horizon;
+        std::optional<uint32_t> region = floor ? floorRegion : ceilingRegion;
+        if (!region) continue;
+
+        // Perpendicular distance, like the fisheye corrected wall distance. The view's right vector is (cos, -sin).
+        float distance = halfHeight / std::max(fabsf((float)y + 0.5f - wallCenter), 0.5f);
+        PlaneRow row = {cameraX + distance * cameraSin, cameraY + distance * cameraCos, distance * cameraCos, -distance * cameraSin};
+        const AtlasRegion &area = atlas.getRegion(*region);
+        frameBuffer.drawPlaneRow((int)y, row, columnTan.data(), floor ? floorLimits.data() : ceilingLimits.data(), atlas.getTexels(*region), area.width, area.height);
+    }
+}
+
+// The view cone reaches as far as the farthest wall in view, nothing beyond it can show. Buckets overlapping its bounding
+// box are tested against the cone as circles, then their sprites one by one. Column x sees the point tan(x) * depth to the
+// right of the view direction, so a sprite covers the columns whose angles lie between the angles of its edges.
+void Renderer::projectSprites(const FrameBuffer &frameBuffer, const SpriteLayer &sprites, float cameraX, float cameraY, float cameraAngle) {
+    constexpr float nearDepth = 0.05f;
+    float reach = *std::max_element(depthBuffer.begin(), depthBuffer.end());
+    float cameraSin = sinf(degreesToRadians(cameraAngle)), cameraCos = cosf(degreesToRadians(cameraAngle));
+    float halfFovTan = tanf(degreesToRadians((float)fov / 2.f)), halfFovSec = sqrtf(1.f + halfFovTan * halfFovTan);
+    float margin = sprites.getMaxWidth() / 2.f;
+
+    // Camera and the two far corners of the cone, the view's right vector is (cos, -sin).
+    float farX = cameraX + reach * cameraSin, farY = cameraY + reach * cameraCos;
+    float sideX = fabsf(reach * halfFovTan * cameraCos), sideY = fabsf(reach * halfFovTan * cameraSin);
+    float bucketSize = (float)SpriteLayer::bucketSize;
+    int firstBucketX = std::max((int)floorf((std::min(cameraX, farX - sideX) - margin) / bucketSize), sprites.getFirstBucketX());
+    int lastBucketX = std::min((int)floorf((std::max(cameraX, farX + sideX) + margin) / bucketSize), sprites.getLastBucketX());
+    int firstBucketY = std::max((int)floorf((std::min(cameraY, farY - sideY) - margin) / bucketSize), sprites.getFirstBucketY());
+    int lastBucketY = std::min((int)floorf((std::max(cameraY, farY + sideY) + margin) / bucketSize), sprites.getLastBucketY());
+    float bucketRadius = bucketSize * 0.70711f + margin;
+
+    float halfHeight = (float)frameBuffer.getHeight() / 2.f, wallCenter = (float)(frameBuffer.getHeight() / 2);
+    float columnsPerDegree = (float)frameBuffer.getLength() / (float)fov;
+    int lastColumn = (int)frameBuffer.getLength() - 1;
+
+    for (int bucketY = firstBucketY; bucketY <= lastBucketY; bucketY++) {
+        for (int bucketX = firstBucketX; bucketX <= lastBucketX; bucketX++) {
+            float centerX = ((float)bucketX + 0.5f) * bucketSize - cameraX, centerY = ((float)bucketY + 0.5f) * bucketSize - cameraY;
+            float centerDepth = centerX * cameraSin + centerY * cameraCos, centerSide = centerX * cameraCos - centerY * cameraSin;
+            if (centerDepth < -bucketRadius || centerDepth - bucketRadius > reach || fabsf(centerSide) - centerDepth * halfFovTan > bucketRadius * halfFovSec)
+                continue;
+
+            for (uint32_t idx : sprites.getBucket(bucketX, bucketY)) {
+                const Sprite &sprite = sprites[idx];
+                const SpriteStyle &style = sprites.getStyle(sprite.kind);
+                float relativeX = sprite.x - cameraX, relativeY = sprite.y - cameraY;
+                float depth = relativeX * cameraSin + relativeY * cameraCos, side = relativeX * cameraCos - relativeY * cameraSin;
+                float halfWidth = style.width / 2.f;
+                if (depth < nearDepth || depth >= reach || fabsf(side) - halfWidth > depth * halfFovTan) continue;
+
+                float leftAngle = atan2f(side - halfWidth, depth) * 180.f / (float)M_PI, rightAngle = atan2f(side + halfWidth, depth) * 180.f / (float)M_PI;
+                int firstX = std::max((int)ceilf((leftAngle + (float)fov / 2.f) * columnsPerDegree), 0);
+                int lastX = std::min((int)floorf((rightAngle + (float)fov / 2.f) * columnsPerDegree), lastColumn);
+                if (firstX > lastX) continue;
+
+                // Standing on the floor, which is as far below the middle row as a wall at the same depth is high.
+                float pixelsPerCell = 2.f * halfHeight / depth;
+                projectedSprites.push_back({depth, side - halfWidth, style.width, wallCenter - halfHeight / depth, style.height * pixelsPerCell, firstX, lastX, style.textureRegion});
+            }
+        }
+    }
+
+    // Drawn from the farthest, so nearer sprites cover farther ones.
+    std::sort(projectedSprites.begin(), projectedSprites.end(), [](const ProjectedSprite &a, const ProjectedSprite &b) { return a.depth > b.depth; });
+    for (std::vector<uint32_t> &tile : tileSprites)
+        tile.clear();
+    for (size_t i = 0; i < projectedSprites.size(); i++) {
+        for (size_t tile = (size_t)projectedSprites[i].firstX / renderTileSize; tile <= (size_t)projectedSprites[i].lastX / renderTileSize; tile++) {
+            tileSprites[tile].push_back((uint32_t)i);
+        }
+    }
+}
+
+void Renderer::drawSprites(FrameBuffer &frameBuffer, const SpriteLayer &sprites, size_t begin, size_t end) {
+    const TextureAtlas &atlas = sprites.getAtlas();
+    for (uint32_t idx : tileSprites[begin / renderTileSize]) {
+        const ProjectedSprite &sprite = projectedSprites[idx];
+        int textureWidth = (int)atlas.getRegion(sprite.textureRegion).width;
+        size_t firstX = std::max((size_t)sprite.firstX, begin), lastX = std::min((size_t)sprite.lastX, end - 1);
+        for (size_t x = firstX; x <= lastX; x++) {
+            if (sprite.depth >= depthBuffer[x]) continue;
+            int textureColumn = std::clamp((int)((columnTan[x] * sprite.depth - sprite.left) / sprite.width * (float)textureWidth), 0, textureWidth - 1);
+            frameBuffer.drawSpriteColumn(x, sprite.bottom, sprite.height, atlas.getColumn(sprite.textureRegion, (size_t)textureColumn), SpriteLayer::transparentPixel);
+        }
+    }
+}
+
+RayHit Renderer::castRay(float originX, float originY, float dirX, float dirY, const Map &map) {
+    if (rayCastingMode == RayCastingMode::Marching)
+        return castRayMarching(originX, originY, dirX, dirY, map);
+    return castRayDDA(originX, originY, dirX, dirY, map);
+}
+
+RayHit Renderer::castRayDDA(float originX, float originY, float dirX, float dirY, const Map &map) {
+    // Kept in locals while stepping, stores to hit could alias the map and have it reloaded on every step.
+    int cellX = (int)originX, cellY = (int)originY;
+    bool hitFromX = false;
+    unsigned int steps = 0;
+
+    int stepX = dirX < 0 ? -1 : 1, stepY = dirY < 0 ? -1 : 1;
+    RayStart start = PacketCaster::startRay(originX, originY, dirX, dirY);
+
+    // Boundaries crossed along each axis, every cell entered crosses one. The next boundaries are computed from them
+    // rather than added up, so they land on the same distances whether cells are crossed in one jump or one at a time.
+    int stepsX = 0, stepsY = 0;
+    auto boundaryX = [&](int n) { return start.sideX + (float)n * start.deltaX; };
+    auto boundaryY = [&](int n) { return start.sideY + (float)n * start.deltaY; };
+
+    // Empty space around the last cell looked up, from its WallDistances: the runs of empty cells ahead of it along
+    // each axis, the rings of empty cells around it and the boundaries crossed when it was looked up. A radius of -1
+    // leaves nothing known without skipping. Cells in the empty row, column or square around it are entered without
+    // looking them up, and where the square is wide the ray crosses whichever of the three it stays in the longest in
+    // one jump. Jumps are rare and slow compared to steps, so they are kept out of the loop.
+    int runX = 0, runY = 0, radius = -1, lookedUpX = 0, lookedUpY = 0, jumpedOver = 0;
+    auto lookUp = [&]() {
+        uint16_t word = map.getWallDistances(cellX, cellY);
+        runX = (int)WallDistances::getRun(word, stepX > 0 ? WallDistances::posX : WallDistances::negX);
+        runY = (int)WallDistances::getRun(word, stepY > 0 ? WallDistances::posY : WallDistances::negY);
+        radius = (int)WallDistances::getRadius(word);
+        lookedUpX = stepsX;
+        lookedUpY = stepsY;
+        return radius >= PacketCaster::minJumpRadius;
+    };
+    auto jump = [&](float nextX, float nextY) {
+        float rowX = boundaryX(stepsX + runX), columnY = boundaryY(stepsY + runY);
+        float squareX = boundaryX(stepsX + radius), squareY = boundaryY(stepsY + radius);
+        float leaveRow = std::min(rowX, nextY), leaveColumn = std::min(nextX, columnY), leaveSquare = std::min(squareX, squareY);
+
+        // Selects rather than branches, which of them the ray stays in longest is as good as random.
+        bool notSquare = (leaveSquare < leaveRow) | (leaveSquare < leaveColumn), row = leaveRow >= leaveColumn;
+        bool useRow = notSquare & row, useColumn = notSquare & !row;
+        int extentX = useColumn ? 0 : useRow ? runX : radius, extentY = useRow ? 0 : useColumn ? runY : radius;
+        float exitX = useColumn ? nextX : useRow ? rowX : squareX, exitY = useColumn ? columnY : useRow ? nextY : squareY;
+
+        // Leaving through an x boundary crosses all x boundaries before it and the y boundaries up to it.
+        bool leaveX = exitX < exitY;
+        int counted = PacketCaster::countBoundaries(leaveX ? start.sideY : start.sideX, leaveX ? start.deltaY : start.deltaX,
+                                                    leaveX ? 1.f / start.deltaY : 1.f / start.deltaX, leaveX ? stepsY : stepsX,
+                                                    leaveX ? extentY : extentX, leaveX ? exitX : exitY, leaveX);
+        int crossedX = leaveX ? extentX : counted, crossedY = leaveX ? counted : extentY;
+        stepsX += crossedX;
+        stepsY += crossedY;
+        cellX += crossedX * stepX;
+        cellY += crossedY * stepY;
+        // One DDA iteration for all of them, the step that follows the jump sets where the ray is.
+        jumpedOver += std::max(crossedX + crossedY - 1, 0);
+        return crossedX + crossedY > 0;
+    };
+    bool jumpNext = emptySkipping && lookUp();
+
+    // Step to whichever boundary is closer until a wall cell is entered. The boundaries after the next ones are
+    // computed before branching, so a mispredicted branch does not wait for them.
+    float nextX = boundaryX(0), nextY = boundaryY(0);
+    while (true) {
+        if (jumpNext && jump(nextX, nextY)) {
+            nextX = boundaryX(stepsX);
+            nextY = boundaryY(stepsY);
+        }
+        jumpNext = false;
+
+        float afterX = boundaryX(stepsX + 1), afterY = boundaryY(stepsY + 1);
+        hitFromX = nextX < nextY;
+        if (hitFromX) {
+            nextX = afterX;
+            stepsX++;
+            cellX += stepX;
+        } else {
+            nextY = afterY;
+            stepsY++;
+            cellY += stepY;
+        }
+        if (emptySkipping) {
+            int aheadX = stepsX - lookedUpX, aheadY = stepsY - lookedUpY;
+            if ((aheadY == 0 && aheadX <= runX) || (aheadX == 0 && aheadY <= runY) || (aheadX <= radius && aheadY <= radius)) continue;
+        }
+        steps++;
+        if (map.isSolid(cellX, cellY)) break;
+        if (emptySkipping) jumpNext = lookUp();
+    }
+
+    RayHit hit;
+    hit.cellX = cellX;
+    hit.cellY = cellY;
+    hit.hitFromX = hitFromX;
+    hit.distance = hitFromX ? boundaryX(stepsX - 1) : boundaryY(stepsY - 1);
+    hit.cells = (unsigned int)(stepsX + stepsY);
+    hit.moves = hit.cells - (unsigned int)jumpedOver;
+    hit.steps = steps;
+
+    hit.x = originX + dirX * hit.distance;
+    hit.y = originY + dirY * hit.distance;
+
+    // Position along the wall face, flipped so textures are never mirrored.
+    if (hit.hitFromX) {
+        hit.textureX = hit.y - floorf(hit.y);
+        if (dirX > 0) hit.textureX = 1.f - hit.textureX;
+    } else {
+        hit.textureX = hit.x - floorf(hit.x);
+        if (dirY < 0) hit.textureX = 1.f - hit.textureX;
+    }
+
+    return hit;
+}
+
+RayHit Renderer::castRayMarching(float originX, float originY, float dirX, float dirY, const Map &map) {
+    RayHit hit;
+    float rayX = originX, rayY = originY; // Ray starts from the player.
+
+    // Calculate ray increments in x, y coordinates
+    float rayXIncrement = dirX / (float)rayCastingPrecision;
+    float rayYIncrement = dirY / (float)rayCastingPrecision;
+
+    // Wall collision check.
+    bool hitWall = false;
+    hit.steps = 0;
+    while (!hitWall) {
+        // Necessary for calculating texture orientation.
+        hit.hitFromX = map.isSolid((int)(rayX + rayXIncrement), (int)rayY);
+
+        rayX += rayXIncrement;
+        rayY += rayYIncrement;
+
+        hitWall = map.isSolid((int)rayX, (int)rayY);
+        hit.steps += 2;
+    }
+    hit.cells = hit.moves = hit.steps;
+
+    hit.x = rayX;
+    hit.y = rayY;
+    hit.cellX = (int)rayX;
+    hit.cellY = (int)rayY;
+
+    // Calculate distance to wall using Pythagoreas theorem
+    hit.distance = sqrtf(fabsf(originX - rayX) * fabsf(originX - rayX) + fabsf(originY - rayY) * fabsf(originY - rayY));
+
+    // One of rayX and rayY is close to edge, so it doesn't affect the chosen coordinate
+    // Flip the textures when necessary.
+    if (!hit.hitFromX) {
+        hit.textureX = rayX - floorf(rayX);
+        if (roundf(rayY) > floorf(rayY)) hit.textureX = 1.f - hit.textureX;
+    } else {
+        hit.textureX = rayY - floorf(rayY);
+        if (roundf(rayX) <= floorf(rayX)) hit.textureX = 1.f - hit.textureX;
+    }
+
+    return hit;
+}
+
+Renderer::~Renderer() {
+    delete pRenderPool;
+}
+
+float Renderer::degreesToRadians(float degrees) {
+    return degrees * (float)M_PI / 180.f;
+}
@@ -0,0 +1,144 @@
+#ifndef rendererH
+#define rendererH
+
+#include <array>
+#include <atomic>
+#include <optional>
+#include <vector>
+
+#include "framebuffer.h"
+#include "map.h"
+#include "packetcaster.h"
+#include "spritelayer.h"
+#include "threadpool.h"
+
+// Wall seen by the ray of one screen column.
+struct WallColumn {
+    RayHit hit;
+    float rayAngle;          // Normalised ray angle in degrees.
+    float wallHeight;        // Half of the wall height on screen, in game pixels.
+    int textureColumn;       // Vertical strip of the wall texture to draw, in textureLevel.
+    uint32_t textureRegion;  // Region of the hit wall's texture in the map's atlas.
+    uint32_t textureLevel;   // Mip level of the texture to draw from.
+};
+
+// Sprite in view, projected onto the screen.
+struct ProjectedSprite {
+    float depth;          // Distance along the view direction, compared with the walls' depth.
+    float left, width;    // Its left edge from the view direction and its width, in cells, at depth.
+    float bottom, height; // Rows it covers on screen, from the bottom, in game pixels.
+    int firstX, lastX;    // Screen columns whose rays pass through it.
+    uint32_t textureRegion;
+};
+
+// Algorithm used for casting rays.
+enum class RayCastingMode {
+    DDA,     // Exact grid traversal, visits each crossed cell once.
+    Marching // Fixed step marching, rayCastingPrecision steps per tile.
+};
+
+// Ray casting renderer, draws what a camera placed in a map sees into a FrameBuffer.
+// Needs no window, so it can also render offscreen.
+class Renderer {
+    ThreadPool *pRenderPool;
+    int fov = 60;
+    unsigned int rayCastingPrecision = 64;
+    static constexpr size_t renderTileSize = FrameBuffer::maxColumns; // Columns rendered by one thread at a time.
+    static constexpr size_t planeTileSize = 8;                         // Floor and ceiling rows drawn by one thread at a time.
+    RayCastingMode rayCastingMode = RayCastingMode::DDA;
+    RayCastingIsa rayCastingIsa = PacketCaster::getBestIsa(); // Only DDA casts packets.
+    bool emptySkipping = true;                   // Skip lookups of cells Map::getWallDistances knows are empty.
+    bool planeCasting = true;                    // Texture the floor and ceiling when the map has textures for them.
+    bool mipmapping = true;                      // Draw walls from the mip level matching their size on screen.
+    std::atomic<unsigned long long> raySteps{0}; // Map lookups done by the last frame.
+    std::atomic<unsigned long long> rayCells{0}; // Cells entered by the last frame's rays.
+    Pixel floorPixel = toPixel(sf::Color(121, 121, 121, 255));
+    std::vector<float> columnSin, columnCos, columnTan; // Of each screen column's angle from the view direction.
+    std::vector<int> floorLimits, ceilingLimits;        // Last floor and first ceiling row of each column, left by its wall.
+    std::vector<float> depthBuffer;                     // Distance of each column's wall along the view direction.
+    std::vector<ProjectedSprite> projectedSprites;      // Sprites in view of the last frame, from the farthest.
+    std::vector<std::vector<uint32_t>> tileSprites;     // Indices into projectedSprites overlapping each tile of columns.
+
+public:
+    // renderThreads set to 0 uses all hardware threads.
+    Renderer(unsigned int renderThreads = 0);
+
+    Renderer(const Renderer &) = delete;
+    Renderer &operator=(const Renderer &) = delete;
+
+    void setRayCastingMode(RayCastingMode mode);
+
+    // Throws std::invalid_argument when the CPU does not support isa.
+    void setRayCastingIsa(RayCastingIsa isa);
+
+    RayCastingIsa getRayCastingIsa();
+
+    // DDA rays enter the empty space the map's wall distances show around cells without looking it up, and cross it
+    // in one jump where it is wide. Boundaries land where stepping cell by cell puts them, so hits are the same either
+    // way and only the number of DDA iterations and lookups changes.
+    void setEmptySkipping(bool skipping);
+
+    // Draw the map's floor and ceiling textures row by row, otherwise the floor is flat and the sky is never covered.
+    void setPlaneCasting(bool casting);
+
+    // Walls draw from the smallest mip level with at least one texel per screen pixel, otherwise always from level 0.
+    void setMipmapping(bool enabled);
+
+    unsigned int getThreadCount();
+
+    // Map lookups done by all rays of the last frame.
+    unsigned long long getRaySteps();
+
+    // Cells entered by all rays of the last frame, at least getRaySteps.
+    unsigned long long getRayCells();
+
+    // Sprites drawn by the last frame.
+    size_t getVisibleSprites();
+
+    // Distance along the view direction of the wall seen by every column of the last frame.
+    const std::vector<float> &getDepthBuffer() const;
+
+    // Render the view from (cameraX, cameraY) looking at cameraAngle into frameBuffer, with pSprites in front of walls
+    // they are closer than.
+    void renderFrame(FrameBuffer &frameBuffer, const Map &map, const Texture &sky, float cameraX, float cameraY, float cameraAngle, const SpriteLayer *pSprites = nullptr);
+
+    // Cast the rays of every column of frameBuffer on the calling thread without drawing, to benchmark ray casting alone.
+    void castColumns(const FrameBuffer &frameBuffer, const Map &map, float cameraX, float cameraY, float cameraAngle, std::vector<WallColumn> &columns);
+
+    ~Renderer();
+
+private:
+    float degreesToRadians(float degrees);
+
+    // Recompute column angles when the frame width changes.
+    void updateColumnAngles(size_t length);
+
+    // Cast the rays of screen columns begin to end and find which part of which wall each of them sees.
+    // Up to RayPacket::maxRays columns, traced together when the ray casting instruction set allows it.
+    void castTile(const FrameBuffer &frameBuffer, const Map &map, size_t begin, size_t end, float playerX, float playerY, float playerAngle, WallColumn *columns);
+
+    // Draw floor, wall and sky of screen columns begin to end in one pass, leaving out floor and sky that
+    // drawPlaneRows textures, and note which rows of each column their walls leave to it.
+    void drawColumns(FrameBuffer &frameBuffer, const TextureAtlas &atlas, const Texture &sky, size_t begin, size_t end, const WallColumn *columns, bool castFloor, bool castCeiling);
+
+    // Draw the floor and ceiling textures of screen rows begin to end that are not covered by walls.
+    void drawPlaneRows(FrameBuffer &frameBuffer, const TextureAtlas &atlas, std::optional<uint32_t> floorRegion, std::optional<uint32_t> ceilingRegion, size_t begin, size_t end, float cameraX, float cameraY, float cameraAngle);
+
+    // Find the sprites of the buckets inside the view cone that are in front of the farthest wall, project them,
+    // sort them from the farthest and note which of them overlap each tile of columns.
+    void projectSprites(const FrameBuffer &frameBuffer, const SpriteLayer &sprites, float cameraX, float cameraY, float cameraAngle);
+
+    // Draw the projected sprites over screen columns begin to end, a tile of them, wherever they are closer than the wall.
+    void drawSprites(FrameBuffer &frameBuffer, const SpriteLayer &sprites, size_t begin, size_t end);
+
+    // Cast a ray from (originX, originY) in direction (dirX, dirY), dir must be normalised.
+    RayHit castRay(float originX, float originY, float dirX, float dirY, const Map &map);
+
+    // Amanatides-Woo traversal, steps from one cell boundary to the next.
+    RayHit castRayDDA(float originX, float originY, float dirX, float dirY, const Map &map);
+
+    // Advances the ray by 1 / rayCastingPrecision of a tile until it is inside a wall.
+    RayHit castRayMarching(float originX, float originY, float dirX, float dirY, const Map &map);
+};
+
+#endif
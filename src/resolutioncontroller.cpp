@@ -0,0 +1,47 @@
+#include "resolutioncontroller.h"
+
+#include <algorithm>
+#include <cmath>
+
+ResolutionController::ResolutionController(size_t length, size_t height, float initialScale, float targetMs, float smallestScale) {
+    maxLength = length;
+    maxHeight = height;
+    minScale = std::clamp(smallestScale, 0.05f, 1.f);
+    scale = std::clamp(initialScale, minScale, 1.f);
+    targetFrameMs = targetMs;
+}
+
+bool ResolutionController::addFrameTime(float frameMs) {
+    if (!isAdaptive()) return false;
+
+    samples[sampleTotal++ % sampleCount] = frameMs;
+    if (sampleTotal < sampleCount) return false;
+
+    // The median ignores single slow frames, like the one loading a new maze.
+    std::array<float, sampleCount> sorted = samples;
+    std::nth_element(sorted.begin(), sorted.begin() + sampleCount / 2, sorted.end());
+    lastMedianMs = sorted[sampleCount / 2];
+    float budgetUse = lastMedianMs / targetFrameMs;
+    if (budgetUse >= lowerBound && budgetUse <= upperBound) return false;
+
+    // Frame time grows with the pixel count, the square of the scale. Aim a little under the target
+    // and limit each change, since only part of the frame time depends on the resolution.
+    float change = std::clamp(std::sqrt(0.9f / budgetUse), 0.7f, 1.15f);
+    float newScale = std::clamp(scale * change, minScale, 1.f);
+    sampleTotal = 0;
+
+    // Kept even when the resolution stays the same, so small corrections add up.
+    size_t oldLength = getLength(), oldHeight = getHeight();
+    scale = newScale;
+    return getLength() != oldLength || getHeight() != oldHeight;
+}
+
+bool ResolutionController::isAdaptive() const { return targetFrameMs > 0; }
+
+size_t ResolutionController::getLength() const { return std::max((size_t)std::lround((float)maxLength * scale), (size_t)1); }
+size_t ResolutionController::getHeight() const { return std::max((size_t)std::lround((float)maxHeight * scale), (size_t)1); }
+float ResolutionController::getScale() const { return scale; }
+
+float ResolutionController::getTargetFrameMs() const { return targetFrameMs; }
+
+float ResolutionController::getBudgetUse() const { return isAdaptive() ? lastMedianMs / targetFrameMs : 0; }
@@ -0,0 +1,42 @@
+#ifndef resolutioncontrollerH
+#define resolutioncontrollerH
+
+#include <array>
+#include <cstddef>
+
+// Picks the render resolution that keeps frame times within a budget, as a fraction of the window resolution.
+// The median of a full window of frames has to leave the band between lowerBound and upperBound of the target
+// before the resolution changes, and the window restarts after every change, so it does not oscillate.
+class ResolutionController {
+    static constexpr size_t sampleCount = 30;     // Frames judged together, about half a second.
+    static constexpr float lowerBound = 0.75f;    // Grow only when frames use less of the budget than this.
+    static constexpr float upperBound = 1.05f;    // Shrink only when frames use more of the budget than this.
+
+    size_t maxLength, maxHeight;
+    float scale, minScale;
+    float targetFrameMs;
+    std::array<float, sampleCount> samples;
+    size_t sampleTotal = 0;
+    float lastMedianMs = 0;
+
+public:
+    // Starts at initialScale of maxLength x maxHeight. targetFrameMs of 0 keeps the resolution fixed.
+    ResolutionController(size_t maxLength, size_t maxHeight, float initialScale, float targetFrameMs, float minScale = 0.25f);
+
+    // Record the time of the last frame, returns true when the resolution changed.
+    bool addFrameTime(float frameMs);
+
+    bool isAdaptive() const;
+
+    // Current render resolution.
+    size_t getLength() const;
+    size_t getHeight() const;
+    float getScale() const;
+
+    float getTargetFrameMs() const;
+
+    // Median frame time of the last full window of frames, over the target. 0 until a window is full.
+    float getBudgetUse() const;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cmath>
+
+#include "spritelayer.h"
+#include "texturecache.h"
+
+const Pixel SpriteLayer::transparentPixel = toPixel(sf::Color(255, 0, 255));
+
+static uint64_t bucketKey(int x, int y) {
+    return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+}
+
+SpriteLayer::SpriteLayer() {
+    // Heights follow the textures' aspect ratio.
+    const std::array<std::pair<const char *, float>, spriteKindCount> kinds = {{
+        {"../textures/breadcrumbSprite.ppm", 0.2f},
+        {"../textures/markerSprite.ppm", 0.7f},
+        {"../textures/pickupSprite.ppm", 0.35f},
+    }};
+    for (size_t kind = 0; kind < spriteKindCount; kind++) {
+        std::shared_ptr<const Texture> texture = TextureCache::get(kinds[kind].first);
+        float spriteWidth = kinds[kind].second;
+        styles[kind] = {atlas.add(*texture), spriteWidth, spriteWidth * (float)texture->getHeight() / (float)texture->getWidth()};
+        maxWidth = std::max(maxWidth, spriteWidth);
+    }
+}
+
+void SpriteLayer::add(float x, float y, SpriteKind kind) {
+    int bucketX = (int)floorf(x / (float)bucketSize), bucketY = (int)floorf(y / (float)bucketSize);
+    if (sprites.empty()) {
+        firstBucketX = lastBucketX = bucketX;
+        firstBucketY = lastBucketY = bucketY;
+    }
+    firstBucketX = std::min(firstBucketX, bucketX);
+    lastBucketX = std::max(lastBucketX, bucketX);
+    firstBucketY = std::min(firstBucketY, bucketY);
+    lastBucketY = std::max(lastBucketY, bucketY);
+    buckets[bucketKey(bucketX, bucketY)].push_back((uint32_t)sprites.size());
+    sprites.push_back({x, y, kind});
+}
+
+std::span<const uint32_t> SpriteLayer::getBucket(int x, int y) const {
+    auto it = buckets.find(bucketKey(x, y));
+    if (it == buckets.end()) return {};
+    return it->second;
+}
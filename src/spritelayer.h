@@ -0,0 +1,76 @@
+#ifndef spritelayerH
+#define spritelayerH
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "textureatlas.h"
+
+// What a sprite shows.
+enum SpriteKind : uint8_t {
+    Breadcrumb = 0,
+    Marker = 1,
+    Pickup = 2,
+    spriteKindCount
+};
+
+// Billboard standing on the floor, always turned towards the camera.
+struct Sprite {
+    float x, y; // Center of its foot, in cells.
+    SpriteKind kind;
+};
+
+// Size on screen and texture of each sprite kind.
+struct SpriteStyle {
+    uint32_t textureRegion; // In SpriteLayer::getAtlas.
+    float width, height;    // In cells.
+};
+
+// Sprites placed in a maze, bucketed into a grid of bucketSize x bucketSize cells, so the renderer
+// only looks at the buckets its view reaches and the cost follows the sprites in view, not all of them.
+// Only buckets holding sprites are stored, so memory follows the sprites and not the size of the maze.
+class SpriteLayer {
+public:
+    static constexpr int bucketSize = 8;
+
+    // Texels of this color are left out, sprite textures have no alpha.
+    static const Pixel transparentPixel;
+
+private:
+    std::vector<Sprite> sprites;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets; // Indices into sprites, by bucket coordinates.
+    int firstBucketX = 0, firstBucketY = 0, lastBucketX = -1, lastBucketY = -1; // Bounds of the buckets holding sprites.
+    TextureAtlas atlas;
+    std::array<SpriteStyle, spriteKindCount> styles;
+    float maxWidth = 0;
+
+public:
+    SpriteLayer();
+
+    void add(float x, float y, SpriteKind kind);
+
+    size_t size() const { return sprites.size(); }
+
+    const Sprite &operator[](size_t idx) const { return sprites[idx]; }
+
+    // Bucket coordinates bounding every bucket that holds sprites, last below first when there are none.
+    int getFirstBucketX() const { return firstBucketX; }
+    int getFirstBucketY() const { return firstBucketY; }
+    int getLastBucketX() const { return lastBucketX; }
+    int getLastBucketY() const { return lastBucketY; }
+
+    // Sprites in the bucket covering cells from (x * bucketSize, y * bucketSize).
+    std::span<const uint32_t> getBucket(int x, int y) const;
+
+    const TextureAtlas &getAtlas() const { return atlas; }
+
+    const SpriteStyle &getStyle(SpriteKind kind) const { return styles[kind]; }
+
+    // Widest sprite kind, in cells.
+    float getMaxWidth() const { return maxWidth; }
+};
+
+#endif
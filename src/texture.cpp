@@ -1,49 +1,171 @@
 #include "texture.h"
-#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fcntl.h>
 #include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// Read only memory mapping of a whole file, unmapped when it goes out of scope.
+struct MappedFile {
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+
+    MappedFile(const std::string &filePath) {
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("cannot open texture " + filePath);
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            size = (size_t)info.st_size;
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) data = (const unsigned char *)mapping;
+        }
+        close(fd);
+
+        if (data == nullptr) throw std::runtime_error("cannot map texture " + filePath);
+        madvise((void *)data, size, MADV_SEQUENTIAL);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() { munmap((void *)data, size); }
+};
+
+// Cursor over the mapped file for parsing .ppm headers and P3 bodies.
+struct PpmReader {
+    const unsigned char *position, *end;
+
+    void skipWhitespace() {
+        while (position < end && (isspace(*position) || *position == '#')) {
+            if (*position == '#') {
+                while (position < end && *position != '\n')
+                    position++;
+            } else {
+                position++;
+            }
+        }
+    }
+
+    size_t readNumber() {
+        skipWhitespace();
+        if (position >= end || !isdigit(*position)) throw std::runtime_error("malformed .ppm file");
+        size_t value = 0;
+        while (position < end && isdigit(*position)) {
+            if (value > (SIZE_MAX - 9) / 10) throw std::runtime_error("number too big in .ppm file");
+            value = value * 10 + (size_t)(*position - '0');
+            position++;
+        }
+        return value;
+    }
+};
+} // namespace
 
 Texture::Texture() {
-    colorMap.push_back({sf::Color::Black});
+    texels = {toPixel(sf::Color::Black)};
+    width = height = 1;
+    powerOfTwo = true;
+    buildMipChain();
 }
 
-// Load texture from P3 .ppm file.
+// Load texture from P6 or P3 .ppm file.
 Texture::Texture(std::string filePath) {
-    std::ifstream file;
-    file.open(filePath);
-
-    int width, height;
-    std::string temp;
-    unsigned int r, g, b;
-
-    // Ignore P3 and max range.
-    file >> temp >> width >> height >> temp;
-
-    // Load rgb values into 2d color vector.
-    for (int i = 0; i < height; i++) {
-        std::vector<sf::Color> currentLine;
-        for (int j = 0; j < width; j++) {
-            file >> r >> g >> b;
-            currentLine.push_back(sf::Color((unsigned char)r, (unsigned char)g, (unsigned char)b, 255));
+    MappedFile file(filePath);
+    PpmReader reader{file.data, file.data + file.size};
+
+    if (file.size < 2 || file.data[0] != 'P' || (file.data[1] != '3' && file.data[1] != '6'))
+        throw std::invalid_argument(filePath + " is not a P3 or P6 .ppm file");
+    bool binary = file.data[1] == '6';
+    reader.position += 2;
+
+    width = reader.readNumber();
+    height = reader.readNumber();
+    size_t maxValue = reader.readNumber();
+    if (width == 0 || height == 0 || maxValue == 0 || maxValue > 255)
+        throw std::invalid_argument(filePath + " has unsupported dimensions or color depth");
+
+    // Exactly one whitespace character separates the header from binary data.
+    if (reader.position >= reader.end || !isspace(*reader.position)) throw std::invalid_argument(filePath + " has a malformed header");
+    reader.position++;
+    if (binary && (size_t)(reader.end - reader.position) / 3 / width < height)
+        throw std::invalid_argument(filePath + " is truncated");
+
+    // Rows in the file go from the top, columns are stored from the bottom.
+    // Decode straight from the mapped pages into the texel buffer.
+    texels.resize(width * height);
+    for (size_t i = 0; i < height; i++) {
+        for (size_t j = 0; j < width; j++) {
+            size_t r, g, b;
+            if (binary) {
+                r = reader.position[0];
+                g = reader.position[1];
+                b = reader.position[2];
+                reader.position += 3;
+            } else {
+                r = reader.readNumber();
+                g = reader.readNumber();
+                b = reader.readNumber();
+            }
+            if (r > maxValue || g > maxValue || b > maxValue)
+                throw std::invalid_argument(filePath + " has a sample above its maximum value");
+            if (maxValue != 255) {
+                r = r * 255 / maxValue;
+                g = g * 255 / maxValue;
+                b = b * 255 / maxValue;
+            }
+            texels[j * height + (height - i - 1)] = toPixel(sf::Color((unsigned char)r, (unsigned char)g, (unsigned char)b, 255));
         }
-        colorMap.push_back(currentLine);
-        currentLine.clear();
     }
-    file.close();
+
+    powerOfTwo = (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+    buildMipChain();
+}
+
+// Blocks at odd edges are clamped, so the last texel of an odd side is averaged with itself.
+// Channels are averaged byte by byte, which works for any channel order of Pixel.
+void Texture::buildMipChain() {
+    levels = {{0, width, height}};
+    while (levels.size() < maxLevels && (levels.back().width > 1 || levels.back().height > 1)) {
+        MipLevel source = levels.back();
+        MipLevel level = {texels.size(), std::max(source.width / 2, (size_t)1), std::max(source.height / 2, (size_t)1)};
+        texels.resize(texels.size() + level.width * level.height);
+
+        for (size_t x = 0; x < level.width; x++) {
+            size_t x1 = std::min(2 * x, source.width - 1), x2 = std::min(2 * x + 1, source.width - 1);
+            for (size_t y = 0; y < level.height; y++) {
+                size_t y1 = std::min(2 * y, source.height - 1), y2 = std::min(2 * y + 1, source.height - 1);
+                const Pixel block[4] = {texels[source.offset + x1 * source.height + y1], texels[source.offset + x1 * source.height + y2],
+                                        texels[source.offset + x2 * source.height + y1], texels[source.offset + x2 * source.height + y2]};
+                Pixel average = 0;
+                for (unsigned int shift = 0; shift < 32; shift += 8) {
+                    Pixel sum = 2;
+                    for (Pixel texel : block)
+                        sum += texel >> shift & 0xff;
+                    average |= (sum / 4) << shift;
+                }
+                texels[level.offset + x * level.height + y] = average;
+            }
+        }
+        levels.push_back(level);
+    }
 }
 
 // Print r, g, b values of colors in array
-void Texture::print() {
-    std::cout << colorMap.size() << std::endl;
-    for (std::vector<sf::Color> line : colorMap) {
-        for (sf::Color color : line) {
+void Texture::print() const {
+    std::cout << height << std::endl;
+    for (size_t i = 0; i < height; i++) {
+        for (size_t j = 0; j < width; j++) {
+            sf::Color color = toColor(getColumn(j)[height - i - 1]);
             std::cout << "(" << (unsigned int)color.r << " " << (unsigned int)color.g << " " << (unsigned int)color.b << ")\t";
         }
         std::cout << std::endl;
     }
 }
 
-size_t Texture::getHeight() { return colorMap.size(); }
-size_t Texture::getWidth() { return colorMap.front().size(); }
-const std::vector<std::vector<sf::Color>> &Texture::getColorMap() {
-    return colorMap;
-}
+size_t Texture::getHeight() const { return height; }
+size_t Texture::getWidth() const { return width; }
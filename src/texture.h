@@ -1,23 +1,58 @@
 #ifndef textureH
 #define textureH
 
-#include<vector>
-#include<SFML/Graphics.hpp>
+#include <span>
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "pixel.h"
+
+// One level of a texture's mip chain.
+struct MipLevel {
+    size_t offset;        // First texel of the level in Texture::getTexels.
+    size_t width, height;
+};
 
 class Texture {
-    std::vector<std::vector<sf::Color>> colorMap;
+    // Texels stored column after column, every column from the bottom row up,
+    // because walls and sky are always drawn as vertical strips.
+    // Level 0 comes first, followed by the smaller levels of the mip chain in the same layout.
+    std::vector<Pixel> texels;
+    std::vector<MipLevel> levels;
+    size_t width, height;
+    bool powerOfTwo;
 
 public:
+    // Levels of the mip chain, enough for textures up to 32768 texels on a side.
+    static constexpr size_t maxLevels = 16;
+
     Texture();
 
-    // Load texture from P3 .ppm file.
+    // Load texture from P6 or P3 .ppm file, throws when it cannot be read.
     Texture(std::string filePath);
 
     // Print r, g, b values of colors in array
-    void print();
+    void print() const;
+
+    size_t getHeight() const;
+    size_t getWidth() const;
+
+    // Wrap a column index into the texture, with a mask when both sides are powers of two.
+    size_t wrapColumn(size_t x) const { return powerOfTwo ? x & (width - 1) : x % width; }
+
+    // Texels of column x, starting from the bottom row.
+    std::span<const Pixel> getColumn(size_t x) const { return {texels.data() + x * height, height}; }
+
+    // All texels of every level, level after level.
+    std::span<const Pixel> getTexels() const { return texels; }
+
+    // Level 0 is the texture itself, each further level halves both sides, rounding down, until both are 1.
+    size_t getLevelCount() const { return levels.size(); }
+    const MipLevel &getLevel(size_t level) const { return levels[level]; }
 
-    size_t getHeight();
-    size_t getWidth();
-    const std::vector<std::vector<sf::Color>> &getColorMap();
+private:
+    // Append the mip chain after level 0, each texel the average of a 2x2 block of the level above.
+    void buildMipChain();
 };
-#endif
\ No newline at end of file
+#endif
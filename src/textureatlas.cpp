@@ -0,0 +1,17 @@
+#include "textureatlas.h"
+
+void TextureAtlas::clear() {
+    texels.clear();
+    regions.clear();
+}
+
+uint32_t TextureAtlas::add(const Texture &texture) {
+    std::span<const Pixel> source = texture.getTexels();
+    AtlasRegion region = {texels.size(), (uint32_t)texture.getWidth(), (uint32_t)texture.getHeight(), (uint32_t)texture.getLevelCount(), {}};
+    for (size_t level = 0; level < texture.getLevelCount(); level++) {
+        region.levelOffsets[level] = (uint32_t)texture.getLevel(level).offset;
+    }
+    regions.push_back(region);
+    texels.insert(texels.end(), source.begin(), source.end());
+    return (uint32_t)regions.size() - 1;
+}
@@ -0,0 +1,61 @@
+#ifndef textureatlasH
+#define textureatlasH
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "texture.h"
+
+// Where one texture lies in a TextureAtlas.
+struct AtlasRegion {
+    size_t offset;          // First texel, columns follow each other from the bottom row up like in Texture.
+    uint32_t width, height; // Of level 0.
+    uint32_t levelCount;    // Mip levels, stored after level 0 like in Texture.
+    std::array<uint32_t, Texture::maxLevels> levelOffsets; // From offset.
+
+    // Levels halve both sides, rounding down, until they are 1.
+    uint32_t getLevelWidth(uint32_t level) const { return std::max(width >> level, 1u); }
+    uint32_t getLevelHeight(uint32_t level) const { return std::max(height >> level, 1u); }
+};
+
+// Textures packed one after another into a single column-major buffer,
+// so a column of any of them is the atlas base pointer plus an offset.
+class TextureAtlas {
+    std::vector<Pixel> texels;
+    std::vector<AtlasRegion> regions;
+
+public:
+    // Forget every texture.
+    void clear();
+
+    // Append a copy of texture, returns the index of its region.
+    uint32_t add(const Texture &texture);
+
+    size_t getRegionCount() const { return regions.size(); }
+
+    const AtlasRegion &getRegion(uint32_t region) const { return regions[region]; }
+
+    // All texels of level 0 of region, column after column.
+    std::span<const Pixel> getTexels(uint32_t region) const {
+        const AtlasRegion &area = regions[region];
+        return {texels.data() + area.offset, (size_t)area.width * area.height};
+    }
+
+    // Texels of column x of region, starting from the bottom row.
+    std::span<const Pixel> getColumn(uint32_t region, size_t x) const {
+        const AtlasRegion &area = regions[region];
+        return {texels.data() + area.offset + x * area.height, area.height};
+    }
+
+    // Texels of column x of mip level of region, starting from the bottom row.
+    std::span<const Pixel> getColumn(uint32_t region, uint32_t level, size_t x) const {
+        const AtlasRegion &area = regions[region];
+        uint32_t height = area.getLevelHeight(level);
+        return {texels.data() + area.offset + area.levelOffsets[level] + x * height, height};
+    }
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "texturecache.h"
+
+std::mutex TextureCache::mutex;
+std::unordered_map<std::string, std::shared_ptr<const Texture>> TextureCache::textures;
+
+std::shared_ptr<const Texture> TextureCache::get(const std::string &filePath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const Texture> &texture = textures[filePath];
+    if (!texture) {
+        try {
+            texture = std::make_shared<const Texture>(filePath);
+        } catch (...) {
+            textures.erase(filePath);
+            throw;
+        }
+    }
+    return texture;
+}
+
+void TextureCache::purgeUnused() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::erase_if(textures, [](const auto &entry) { return entry.second.use_count() == 1; });
+}
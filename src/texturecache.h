@@ -0,0 +1,24 @@
+#ifndef texturecacheH
+#define texturecacheH
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "texture.h"
+
+// Process wide cache of loaded textures keyed by file path.
+class TextureCache {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const Texture>> textures;
+
+public:
+    // Texture from filePath, the file is only read the first time it is requested.
+    static std::shared_ptr<const Texture> get(const std::string &filePath);
+
+    // Drop textures which are referenced only by the cache.
+    static void purgeUnused();
+};
+
+#endif
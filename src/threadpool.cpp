@@ -0,0 +1,85 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    threadCount = threads == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : threads;
+    queues = std::make_unique<TileQueue[]>(threadCount);
+
+    // The thread calling parallelFor works as well, so it needs one less worker.
+    for (unsigned int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+unsigned int ThreadPool::getThreadCount() { return threadCount; }
+
+void ThreadPool::parallelFor(size_t count, size_t tileSize, const std::function<void(size_t, size_t)> &task) {
+    if (count == 0) return;
+    tileSize = std::max(tileSize, (size_t)1);
+    size_t tiles = (count + tileSize - 1) / tileSize;
+
+    if (threadCount == 1 || tiles == 1) {
+        for (size_t begin = 0; begin < count; begin += tileSize)
+            task(begin, std::min(begin + tileSize, count));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Give each thread an equal share of tiles, uneven costs are balanced by stealing.
+        for (unsigned int i = 0; i < threadCount; i++) {
+            queues[i].next.store(tiles * i / threadCount, std::memory_order_relaxed);
+            queues[i].end = tiles * (i + 1) / threadCount;
+        }
+        pTask = &task;
+        taskCount = count;
+        taskTileSize = tileSize;
+        busyWorkers = threadCount - 1;
+        generation++;
+    }
+    startCondition.notify_all();
+
+    runTiles(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+    pTask = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    unsigned long seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        runTiles(index);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::runTiles(unsigned int index) {
+    for (unsigned int i = 0; i < threadCount; i++) {
+        TileQueue &queue = queues[(index + i) % threadCount];
+        size_t tile;
+        while ((tile = queue.next.fetch_add(1, std::memory_order_relaxed)) < queue.end) {
+            size_t begin = tile * taskTileSize;
+            (*pTask)(begin, std::min(begin + taskTileSize, taskCount));
+        }
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
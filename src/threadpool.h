@@ -0,0 +1,53 @@
+#ifndef threadpoolH
+#define threadpoolH
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads, used to split work into tiles.
+class ThreadPool {
+    // Consecutive tiles owned by one worker. Idle workers steal from the front of other queues.
+    struct alignas(64) TileQueue {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<TileQueue[]> queues;
+    unsigned int threadCount;
+
+    std::mutex mutex;
+    std::condition_variable startCondition, doneCondition;
+    const std::function<void(size_t, size_t)> *pTask = nullptr;
+    size_t taskCount = 0, taskTileSize = 1;
+    unsigned long generation = 0;
+    unsigned int busyWorkers = 0;
+    bool stopping = false;
+
+public:
+    // threads includes the calling thread, 0 uses all hardware threads.
+    ThreadPool(unsigned int threads = 0);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned int getThreadCount();
+
+    // Calls task(begin, end) for tiles of tileSize covering [0, count) and waits until all are done.
+    void parallelFor(size_t count, size_t tileSize, const std::function<void(size_t, size_t)> &task);
+
+    ~ThreadPool();
+
+private:
+    void workerLoop(unsigned int index);
+
+    // Run own tiles, then steal from the other queues until all of them are empty.
+    void runTiles(unsigned int index);
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "walldistances.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mazegenerator.h"
+
+// Each run is one more than the neighbour's in that direction, or 0 next to a wall. Scans start maxRun cells past
+// the area with a run of 0, by the time they reach it a run is either correct or already saturated. Radii come from
+// a two pass chessboard distance transform of the area and maxRadius + 1 cells around it, walls further away cannot
+// bring a radius under maxRadius.
+void WallDistances::compute(const uint8_t *tiles, size_t tileStride, int width, int height, int x0, int y0, int w, int h, uint16_t *distances, size_t distanceStride) {
+    // Saturates at maxRun, restarts from 0 after a wall.
+    auto next = [](uint8_t tile, unsigned run) { return (run + (run != maxRun)) & -(unsigned)(tile == Empty); };
+    int firstX = std::max(x0 - (int)maxRun, 0), lastX = std::min(x0 + w - 1 + (int)maxRun, width - 1);
+    int firstY = std::max(y0 - (int)maxRun, 0), lastY = std::min(y0 + h - 1 + (int)maxRun, height - 1);
+
+    for (int y = y0; y < y0 + h; y++) {
+        const uint8_t *pTiles = tiles + (size_t)y * tileStride;
+        uint16_t *pDistances = distances + (size_t)(y - y0) * distanceStride - x0;
+        unsigned run = 0;
+        for (int x = lastX; x >= x0; x--) {
+            if (x < x0 + w) pDistances[x] = (uint16_t)(run << posX);
+            run = next(pTiles[x], run);
+        }
+        run = 0;
+        for (int x = firstX; x < x0 + w; x++) {
+            if (x >= x0) pDistances[x] = (uint16_t)(pDistances[x] | run << negX);
+            run = next(pTiles[x], run);
+        }
+    }
+
+    // Columns advance together row by row, so the tiles are read in order.
+    std::vector<unsigned> runs((size_t)w);
+    for (int y = lastY; y >= y0; y--) {
+        const uint8_t *pTiles = tiles + (size_t)y * tileStride + x0;
+        uint16_t *pDistances = distances + (size_t)(y - y0) * distanceStride;
+        for (size_t i = 0; i < (size_t)w; i++) {
+            if (y < y0 + h) pDistances[i] = (uint16_t)(pDistances[i] | runs[i] << posY);
+            runs[i] = next(pTiles[i], runs[i]);
+        }
+    }
+    std::fill(runs.begin(), runs.end(), 0);
+    for (int y = firstY; y < y0 + h; y++) {
+        const uint8_t *pTiles = tiles + (size_t)y * tileStride + x0;
+        uint16_t *pDistances = distances + (size_t)(y - y0) * distanceStride;
+        for (size_t i = 0; i < (size_t)w; i++) {
+            if (y >= y0) pDistances[i] = (uint16_t)(pDistances[i] | runs[i] << negY);
+            runs[i] = next(pTiles[i], runs[i]);
+        }
+    }
+
+    // Chebyshev distances to the nearest wall, capped at far. Cells past the grid's edges are walls.
+    constexpr int margin = (int)maxRadius + 1;
+    constexpr uint8_t far = (uint8_t)(maxRadius + 1);
+    int padX = x0 - margin, padY = y0 - margin, padW = w + 2 * margin, padH = h + 2 * margin;
+    std::vector<uint8_t> chebyshev((size_t)padW * (size_t)padH);
+    for (int j = 0; j < padH; j++) {
+        for (int i = 0; i < padW; i++) {
+            int x = padX + i, y = padY + j;
+            bool wall = x < 0 || y < 0 || x >= width || y >= height || tiles[(size_t)y * tileStride + (size_t)x] != Empty;
+            chebyshev[(size_t)j * (size_t)padW + (size_t)i] = wall ? 0 : far;
+        }
+    }
+    auto relax = [&](int i, int j, int di, int dj) {
+        uint8_t &d = chebyshev[(size_t)j * (size_t)padW + (size_t)i];
+        int ni = i + di, nj = j + dj;
+        if (ni >= 0 && ni < padW && nj >= 0 && nj < padH) d = std::min(d, (uint8_t)(chebyshev[(size_t)nj * (size_t)padW + (size_t)ni] + 1));
+    };
+    for (int j = 0; j < padH; j++) {
+        for (int i = 0; i < padW; i++) {
+            relax(i, j, -1, 0);
+            relax(i, j, -1, -1);
+            relax(i, j, 0, -1);
+            relax(i, j, 1, -1);
+        }
+    }
+    for (int j = padH - 1; j >= 0; j--) {
+        for (int i = padW - 1; i >= 0; i--) {
+            relax(i, j, 1, 0);
+            relax(i, j, 1, 1);
+            relax(i, j, 0, 1);
+            relax(i, j, -1, 1);
+        }
+    }
+    for (int y = y0; y < y0 + h; y++) {
+        const uint8_t *pChebyshev = &chebyshev[(size_t)(y - padY) * (size_t)padW + (size_t)margin];
+        uint16_t *pDistances = distances + (size_t)(y - y0) * distanceStride;
+        for (size_t i = 0; i < (size_t)w; i++) {
+            unsigned rings = std::min((unsigned)std::max((int)pChebyshev[i] - 1, 0), maxRadius);
+            pDistances[i] = (uint16_t)(pDistances[i] | rings << radius);
+        }
+    }
+}
+
+WallDistanceBlocks::WallDistanceBlocks(WallDistanceBlocks &&other) noexcept
+    : width(other.width), height(other.height), blocksX(other.blocksX), blockCount(other.blockCount), blocks(std::move(other.blocks)) {
+    other.blockCount = 0;
+}
+
+WallDistanceBlocks &WallDistanceBlocks::operator=(WallDistanceBlocks &&other) noexcept {
+    if (this != &other) {
+        release();
+        width = other.width;
+        height = other.height;
+        blocksX = other.blocksX;
+        blockCount = other.blockCount;
+        blocks = std::move(other.blocks);
+        other.blockCount = 0;
+    }
+    return *this;
+}
+
+WallDistanceBlocks::~WallDistanceBlocks() { release(); }
+
+void WallDistanceBlocks::release() {
+    for (size_t i = 0; i < blockCount; i++) {
+        delete[] blocks[i].exchange(nullptr);
+    }
+}
+
+void WallDistanceBlocks::reset(int gridWidth, int gridHeight) {
+    release();
+    width = gridWidth;
+    height = gridHeight;
+    blocksX = (width + blockSize - 1) / blockSize;
+    blockCount = (size_t)blocksX * (size_t)((height + blockSize - 1) / blockSize);
+    blocks = std::make_unique<std::atomic<uint16_t *>[]>(blockCount);
+}
+
+// Radii count walls up to maxRadius + 1 cells away in every direction, runs only maxRun along the row and column.
+void WallDistanceBlocks::invalidate(int x, int y) {
+    int reach = (int)WallDistances::maxRadius + 1;
+    int lastBlockX = (width - 1) >> blockShift, lastBlockY = (height - 1) >> blockShift;
+    for (int blockY = std::max(y - reach, 0) >> blockShift; blockY <= std::min((y + reach) >> blockShift, lastBlockY); blockY++) {
+        for (int blockX = std::max(x - reach, 0) >> blockShift; blockX <= std::min((x + reach) >> blockShift, lastBlockX); blockX++)
+            delete[] blocks[(size_t)blockY * (size_t)blocksX + (size_t)blockX].exchange(nullptr);
+    }
+}
+
+const uint16_t *WallDistanceBlocks::build(const uint8_t *tiles, size_t idx) const {
+    int blockX = (int)(idx % (size_t)blocksX), blockY = (int)(idx / (size_t)blocksX);
+    int x0 = blockX * blockSize, y0 = blockY * blockSize;
+    uint16_t *pBlock = new uint16_t[blockSize * blockSize]();
+    WallDistances::compute(tiles, (size_t)width, width, height, x0, y0, std::min(blockSize, width - x0), std::min(blockSize, height - y0), pBlock, blockSize);
+
+    uint16_t *pExpected = nullptr;
+    if (!blocks[idx].compare_exchange_strong(pExpected, pBlock, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        delete[] pBlock;
+        return pExpected;
+    }
+    return pBlock;
+}
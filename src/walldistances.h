@@ -0,0 +1,64 @@
+#ifndef walldistancesH
+#define walldistancesH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// How far the empty space around a cell reaches, packed into one 16 bit word per cell. Four runs count the empty
+// cells between the cell and the nearest wall in each axis direction, up to maxRun, and radius counts the rings of
+// empty cells around it, its Chebyshev distance to the nearest wall less one, up to maxRadius. The runs reach along
+// corridors, the radius across open areas, the shifts below give each field's place in the word.
+struct WallDistances {
+    static constexpr unsigned maxRun = 7, maxRadius = 15;
+    static constexpr unsigned posX = 0, negX = 3, posY = 6, negY = 9, radius = 12;
+
+    static unsigned getRun(uint16_t word, unsigned shift) { return word >> shift & maxRun; }
+    static unsigned getRadius(uint16_t word) { return word >> radius; }
+
+    // Fill the words of the w x h cells from (x0, y0) of a width x height grid of tiles whose rows are tileStride apart,
+    // into distances whose rows are distanceStride apart. Looks at most maxRadius + 1 cells past the area, the grid's
+    // edges count as walls.
+    static void compute(const uint8_t *tiles, size_t tileStride, int width, int height, int x0, int y0, int w, int h, uint16_t *distances, size_t distanceStride);
+};
+
+// WallDistances of a flat maze, built a block of blockSize x blockSize cells at a time the first time a ray reads one,
+// so memory and time follow the part of the maze rays reach, not its size. Safe to read from several threads,
+// two threads racing for the same block build identical copies and one is thrown away.
+class WallDistanceBlocks {
+public:
+    static constexpr int blockShift = 6, blockSize = 1 << blockShift;
+
+private:
+    int width = 0, height = 0, blocksX = 0;
+    size_t blockCount = 0;
+    std::unique_ptr<std::atomic<uint16_t *>[]> blocks; // Row after row of blocks, nullptr until built.
+
+public:
+    WallDistanceBlocks() = default;
+    WallDistanceBlocks(WallDistanceBlocks &&other) noexcept;
+    WallDistanceBlocks &operator=(WallDistanceBlocks &&other) noexcept;
+    ~WallDistanceBlocks();
+
+    // Drop every block, for a grid of width x height tiles.
+    void reset(int gridWidth, int gridHeight);
+
+    // Drop the blocks holding words a change of the tile at (x, y) can affect. Must not run while rays read.
+    void invalidate(int x, int y);
+
+    // Word of the cell at (x, y) of tiles, the grid given to reset.
+    uint16_t get(const uint8_t *tiles, int x, int y) const {
+        size_t idx = (size_t)(y >> blockShift) * (size_t)blocksX + (size_t)(x >> blockShift);
+        const uint16_t *pBlock = blocks[idx].load(std::memory_order_acquire);
+        if (pBlock == nullptr) pBlock = build(tiles, idx);
+        return pBlock[(y & (blockSize - 1)) * blockSize + (x & (blockSize - 1))];
+    }
+
+private:
+    const uint16_t *build(const uint8_t *tiles, size_t idx) const;
+
+    void release();
+};
+
+#endif
@@ -4,38 +4,26 @@
 #include <SFML/Graphics.hpp>
 #include <cmath>
 
-#include "texture.h"
+#include "framebuffer.h"
 
-// Rendering window class.
+// Window showing frames rendered into a FrameBuffer.
 class Window {
     sf::RenderWindow *pRenderWindow;
-    size_t gameLength, gameHeight, trueHeight, trueLength;
-    sf::VertexArray pixels;
+    size_t gameLength, gameHeight;     // Resolution of the last frame.
+    size_t windowLength, windowHeight;
+    sf::Texture frame;         // Frame uploaded to the GPU, big enough for frames at window resolution.
+    sf::Sprite frameSprite;    // Draws the used part of frame upscaled to the window in one pass on the GPU.
     int scaleModifier;
     bool visibility = true;
 
 public:
-    Window(size_t length, size_t height, int scale, std::string title) ;
+    // smooth upscales frames bilinearly instead of with nearest neighbour.
+    Window(size_t length, size_t height, int scale, std::string title, bool smooth = false);
 
     bool isOpen();
 
-    // Set the color of pixel in coords x, y
-    void setTruePixelColor(int x, int y, const sf::Color &color);
-
-    // Set the color of a simulation pixel
-    void setGamePixelColor(int x, int y, sf::Color color);
-
-    // Draw a vertical line.
-    void drawVericalLine(int y1, int y2, int x, const sf::Color &color);
-
-    // Draws a vertical strip of a texture, texturePositionX determines which.
-    void drawTextureVerticalLine(int x, float y1, float y2, int texturePositionX, Texture &texture);
-
-    // Must be a separate function to avoid float precision artifacts at half height
-    void drawWallTextureVerticalLine(int x, float wallHeight, int texturePositionX, Texture &texture);
-
-    // Push updates to display
-    void display();
+    // Upload frameBuffer and push it to display, it can have any resolution up to the window's.
+    void display(const FrameBuffer &frameBuffer);
 
     void toggleVisibility();
 